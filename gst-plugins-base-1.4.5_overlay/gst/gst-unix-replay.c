@@ -0,0 +1,204 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Serve a capture recorded with unixclientsrc capture-location=... to
+ * unixclientsrc clients, with the timing and read sizes it was recorded
+ * with, sped up or as fast as possible. Every client gets the whole
+ * capture, from the start, in a thread of its own.
+ *
+ *   gst-unix-replay --path=/tmp/unix.sock --capture=/tmp/stream.ucap --speed=2
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+
+#include "gstunixcapture.h"
+#include "gstunixprotocol.h"
+#include "gstunixlatency.h"
+
+/* the protocol helpers log to the plugin's category */
+GST_DEBUG_CATEGORY (tcp_debug);
+
+static gchar *path = NULL;
+static gchar *capture = NULL;
+static gdouble speed = 1.0;
+static gboolean loop = FALSE;
+
+static GstUNIXCaptureFile *file = NULL;
+
+static GOptionEntry entries[] = {
+  {"path", 'p', 0, G_OPTION_ARG_FILENAME, &path,
+      "Socket to listen on", "PATH"},
+  {"capture", 'c', 0, G_OPTION_ARG_FILENAME, &capture,
+      "Capture file to replay", "FILE"},
+  {"speed", 's', 0, G_OPTION_ARG_DOUBLE, &speed,
+      "Replay speed, 1 = as recorded, 0 = as fast as possible", "FACTOR"},
+  {"loop", 'l', 0, G_OPTION_ARG_NONE, &loop,
+      "Start over at the end of the capture instead of closing", NULL},
+  {NULL}
+};
+
+/* send the capture once, returns FALSE when the client went away */
+static gboolean
+replay_once (GSocket * socket, guint64 * bytes, GstClockTime * late)
+{
+  const GstUNIXCaptureRecord *record;
+  const guint8 *data;
+  GstClockTime start = 0, first = GST_CLOCK_TIME_NONE;
+  gsize offset = 0;
+  GError *err = NULL;
+
+  while (gst_unix_capture_file_next (file, &offset, &record, &data)) {
+    GOutputVector vec;
+
+    if (speed > 0) {
+      GstClockTime now, target;
+
+      if (first == GST_CLOCK_TIME_NONE) {
+        /* the time until the first read is not part of the stream */
+        first = record->time;
+        start = gst_unix_latency_now ();
+      }
+      target = start + (GstClockTime) ((record->time - first) / speed);
+      now = gst_unix_latency_now ();
+      if (now < target)
+        g_usleep ((target - now) / GST_USECOND);
+      else
+        *late = MAX (*late, now - target);
+    }
+
+    vec.buffer = data;
+    vec.size = record->size;
+    if (!gst_unix_socket_send_all (socket, &vec, 1, NULL, &err)) {
+      g_printerr ("client %p: %s\n", socket, err->message);
+      g_clear_error (&err);
+      return FALSE;
+    }
+    *bytes += record->size;
+  }
+
+  return TRUE;
+}
+
+static gpointer
+replay_client (gpointer data)
+{
+  GSocket *socket = data;
+  const GstUNIXCaptureHeader *header;
+  GstClockTime start, late = 0;
+  guint64 bytes = 0;
+  GError *err = NULL;
+
+  /* a framed capture starts right after the handshake, the hello of the
+   * client is not part of it */
+  header = gst_unix_capture_file_get_header (file);
+  if (header->flags & GST_UNIX_CAPTURE_FLAG_FRAMED) {
+    GstStructure *hello;
+
+    hello = gst_unix_protocol_receive_hello (socket, NULL, &err);
+    if (!hello) {
+      g_printerr ("client %p: %s\n", socket, err->message);
+      g_clear_error (&err);
+      goto done;
+    }
+    gst_structure_free (hello);
+  }
+
+  start = gst_unix_latency_now ();
+  while (replay_once (socket, &bytes, &late) && loop);
+
+  g_print ("client %p: %" G_GUINT64_FORMAT " bytes in %" GST_TIME_FORMAT
+      ", at most %" GST_TIME_FORMAT " behind schedule\n", socket, bytes,
+      GST_TIME_ARGS (gst_unix_latency_now () - start), GST_TIME_ARGS (late));
+
+done:
+  g_socket_close (socket, NULL);
+  g_object_unref (socket);
+
+  return NULL;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GSocketAddress *addr;
+  GSocket *server;
+  GError *err = NULL;
+
+  ctx = g_option_context_new ("- replay a UNIX transport capture");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  GST_DEBUG_CATEGORY_INIT (tcp_debug, "tcp", 0, "TCP calls");
+
+  if (!path || !capture || speed < 0) {
+    g_printerr ("need --path, --capture and a speed >= 0\n");
+    return 1;
+  }
+
+  file = gst_unix_capture_file_open (capture, &err);
+  if (!file)
+    goto failed;
+
+  server = g_socket_new (G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM,
+      G_SOCKET_PROTOCOL_DEFAULT, &err);
+  if (!server)
+    goto failed;
+
+  /* a previous run may have left its socket behind */
+  g_unlink (path);
+  addr = g_unix_socket_address_new (path);
+  if (!g_socket_bind (server, addr, TRUE, &err) ||
+      !g_socket_listen (server, &err))
+    goto failed;
+  g_object_unref (addr);
+
+  g_print ("replaying %s on %s\n", capture, path);
+
+  while (TRUE) {
+    GSocket *client;
+
+    client = g_socket_accept (server, NULL, &err);
+    if (!client)
+      goto failed;
+
+    g_thread_unref (g_thread_new ("replay", replay_client, client));
+  }
+
+  return 0;
+
+failed:
+  {
+    g_printerr ("%s\n", err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+}
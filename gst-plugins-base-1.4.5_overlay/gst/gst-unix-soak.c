@@ -0,0 +1,666 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Soak a unixserversink with connection churn and misbehaving consumers.
+ * The sink runs in this process; hundreds of client threads connect to it
+ * with scripted behaviors for a given time:
+ *
+ *   fast       reads everything as soon as it arrives, the healthy client
+ *   slow       sleeps between buffers, reconnects when dropped
+ *   stalled    connects and never reads
+ *   flapping   connects, reads for a moment and disconnects, over and over
+ *   half-open  connects and never says hello, over and over
+ *
+ * Afterwards it checks that the server process did not grow, that every
+ * client socket was closed again, that fast clients got every buffer in
+ * time and that stopping the sink removes its socket and leaves no fds
+ * behind. The results go to
+ * stdout as one JSON object, the exit status tells whether all checks
+ * passed. The plugin is loaded from the registry, so run it with
+ * GST_PLUGIN_PATH pointing at the build directory:
+ *
+ *   gst-unix-soak --clients=300 --duration=600 --mix=fast=40,slow=20,stalled=10,flapping=20,half-open=10
+ *
+ * make check runs gst-unix-soak-short, the same program with a few clients
+ * for a few seconds and looser latency and throughput limits by default.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+#include "gstunixclient.h"
+#include "gstunixlatency.h"
+
+/* how often clients look at the clock while blocked */
+#define POLL_INTERVAL   (200 * GST_MSECOND)
+
+#ifndef SOAK_DEFAULT_DURATION
+#define SOAK_DEFAULT_DURATION   60
+#endif
+#ifndef SOAK_DEFAULT_CLIENTS
+#define SOAK_DEFAULT_CLIENTS    200
+#endif
+#ifndef SOAK_DEFAULT_MAX_LATENCY
+#define SOAK_DEFAULT_MAX_LATENCY        50
+#endif
+#ifndef SOAK_DEFAULT_MIN_THROUGHPUT
+#define SOAK_DEFAULT_MIN_THROUGHPUT     0.95
+#endif
+
+typedef enum
+{
+  BEHAVIOR_FAST,
+  BEHAVIOR_SLOW,
+  BEHAVIOR_STALLED,
+  BEHAVIOR_FLAPPING,
+  BEHAVIOR_HALF_OPEN,
+  N_BEHAVIORS
+} Behavior;
+
+static const gchar *behavior_names[N_BEHAVIORS] = {
+  "fast", "slow", "stalled", "flapping", "half-open"
+};
+
+typedef struct
+{
+  guint index;
+  Behavior behavior;
+  GThread *thread;
+
+  /* only written by the client thread */
+  guint64 frames;
+  guint64 bytes;
+  /* the client's share of the stream is measured from its first frame on,
+   * not from the time it was started: sink_bytes at that frame and what
+   * the client got after it */
+  gint stream_start;
+  guint64 share_bytes;
+  guint64 connects;
+  guint64 errors;
+  gboolean dropped;             /* the server closed the connection */
+  GstUNIXHistogram latency;
+} SoakClient;
+
+static gchar *path = NULL;
+static gint duration = SOAK_DEFAULT_DURATION;
+static gint n_clients = SOAK_DEFAULT_CLIENTS;
+static gchar *mix = NULL;
+static gchar *source = NULL;
+static gchar *sink_properties = NULL;
+static gint slow_delay = 100;
+static gint flap_interval = 50;
+static gint settle = 3;
+static gint max_rss_growth = 16384;
+static gint max_latency = SOAK_DEFAULT_MAX_LATENCY;
+static gdouble min_throughput = SOAK_DEFAULT_MIN_THROUGHPUT;
+
+static GOptionEntry entries[] = {
+  {"path", 'p', 0, G_OPTION_ARG_FILENAME, &path,
+      "Socket for the sink, removed first (default: in a new temporary "
+        "directory)", "PATH"},
+  {"duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+      "Seconds to run the clients for", "SECONDS"},
+  {"clients", 'n', 0, G_OPTION_ARG_INT, &n_clients,
+      "Number of clients", "N"},
+  {"mix", 'm', 0, G_OPTION_ARG_STRING, &mix,
+      "Share of each behavior, e.g. fast=50,slow=20,stalled=10,"
+        "flapping=15,half-open=5", "MIX"},
+  {"source", 's', 0, G_OPTION_ARG_STRING, &source,
+      "Pipeline description feeding the sink", "PIPELINE"},
+  {"sink-properties", 0, 0, G_OPTION_ARG_STRING, &sink_properties,
+      "Additional properties of the sink", "PROPERTIES"},
+  {"slow-delay", 0, 0, G_OPTION_ARG_INT, &slow_delay,
+      "Milliseconds slow clients sleep per buffer", "MS"},
+  {"flap-interval", 0, 0, G_OPTION_ARG_INT, &flap_interval,
+      "Milliseconds flapping clients stay connected", "MS"},
+  {"settle", 0, 0, G_OPTION_ARG_INT, &settle,
+      "Seconds to give the sink to notice the last disconnects", "SECONDS"},
+  {"max-rss-growth", 0, 0, G_OPTION_ARG_INT, &max_rss_growth,
+      "Allowed growth of the resident set in KiB", "KIB"},
+  {"max-latency", 0, 0, G_OPTION_ARG_INT, &max_latency,
+      "Allowed 99th percentile delivery latency of fast clients", "MS"},
+  {"min-throughput", 0, 0, G_OPTION_ARG_DOUBLE, &min_throughput,
+      "Share of the stream every fast client must receive", "RATIO"},
+  {NULL}
+};
+
+static GstClockTime deadline;
+static volatile gint sink_bytes = 0;    /* in KiB, see count_bytes() */
+
+static GstPadProbeReturn
+count_bytes (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  static gsize rest = 0;
+  gsize size = rest + gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+
+  /* streaming thread only, the counter itself is read from main */
+  g_atomic_int_add (&sink_bytes, size / 1024);
+  rest = size % 1024;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gsize
+read_rss (void)
+{
+  gchar *contents = NULL;
+  gulong size = 0, resident = 0;
+
+  if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    sscanf (contents, "%lu %lu", &size, &resident);
+  g_free (contents);
+
+  return resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+static guint
+count_fds (void)
+{
+  GDir *dir;
+  guint count = 0;
+
+  if (!(dir = g_dir_open ("/proc/self/fd", 0, NULL)))
+    return 0;
+  while (g_dir_read_name (dir))
+    count++;
+  g_dir_close (dir);
+
+  /* not counting the fd of the directory itself */
+  return count - 1;
+}
+
+static void
+histogram_merge (GstUNIXHistogram * dest, const GstUNIXHistogram * src)
+{
+  guint i;
+
+  for (i = 0; i < GST_UNIX_HISTOGRAM_BUCKETS; i++)
+    dest->buckets[i] += src->buckets[i];
+  dest->count += src->count;
+  dest->total += src->total;
+  dest->min = MIN (dest->min, src->min);
+  dest->max = MAX (dest->max, src->max);
+}
+
+static GstUNIXClient *
+client_connect (SoakClient * client)
+{
+  GstUNIXClientOptions options = { 1, 0, NULL };
+  GstUNIXClient *conn;
+  struct timeval tv;
+
+  if (!(conn = gst_unix_client_connect (path, &options))) {
+    client->errors++;
+    return NULL;
+  }
+  client->connects++;
+
+  /* wake up regularly to look at the deadline */
+  tv.tv_sec = 0;
+  tv.tv_usec = POLL_INTERVAL / GST_USECOND;
+  setsockopt (gst_unix_client_get_fd (conn), SOL_SOCKET, SO_RCVTIMEO, &tv,
+      sizeof (tv));
+
+  return conn;
+}
+
+/* read until @until, sleeping @delay after every buffer. Returns FALSE
+ * when the server closed the connection */
+static gboolean
+client_read (SoakClient * client, GstUNIXClient * conn, GstClockTime delay,
+    GstClockTime until)
+{
+  GstUNIXClientFrame frame;
+  gsize size = 64 * 1024;
+  guint8 *data = g_malloc (size);
+  gboolean ret = TRUE;
+  gint res;
+
+  while (gst_unix_latency_now () < until) {
+    res = gst_unix_client_receive (conn, &frame, data, size);
+    if (res > 0) {
+      if (client->stream_start < 0)
+        client->stream_start = g_atomic_int_get (&sink_bytes);
+      else
+        client->share_bytes += frame.size;
+      client->frames++;
+      client->bytes += frame.size;
+      if (frame.send_time)
+        gst_unix_histogram_record (&client->latency,
+            gst_unix_latency_now () - frame.send_time);
+      if (delay)
+        g_usleep (delay / GST_USECOND);
+    } else if (res == 0) {
+      ret = FALSE;
+      break;
+    } else if (errno == EMSGSIZE) {
+      size = frame.size;
+      data = g_realloc (data, size);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      /* reset by the server while reading */
+      client->errors++;
+      ret = FALSE;
+      break;
+    }
+  }
+  g_free (data);
+
+  return ret;
+}
+
+static void
+client_wait (GstClockTime until)
+{
+  GstClockTime now;
+
+  while ((now = gst_unix_latency_now ()) < until)
+    g_usleep (MIN (until - now, POLL_INTERVAL) / GST_USECOND);
+}
+
+/* connect without ever saying hello and wait for the server to give up */
+static void
+client_half_open (SoakClient * client)
+{
+  struct sockaddr_un addr;
+  struct pollfd pfd;
+  gchar byte;
+  gint fd;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  g_strlcpy (addr.sun_path, path, sizeof (addr.sun_path));
+
+  if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    client->errors++;
+    client_wait (gst_unix_latency_now () + flap_interval * GST_MSECOND);
+    return;
+  }
+  if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+    client->errors++;
+    close (fd);
+    client_wait (gst_unix_latency_now () + flap_interval * GST_MSECOND);
+    return;
+  }
+  client->connects++;
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  while (gst_unix_latency_now () < deadline) {
+    if (poll (&pfd, 1, POLL_INTERVAL / GST_MSECOND) > 0) {
+      if (recv (fd, &byte, 1, 0) <= 0) {
+        client->dropped = TRUE;
+        break;
+      }
+    }
+  }
+  close (fd);
+}
+
+static gpointer
+client_thread (gpointer data)
+{
+  SoakClient *client = data;
+  GstUNIXClient *conn;
+
+  while (gst_unix_latency_now () < deadline) {
+    switch (client->behavior) {
+      case BEHAVIOR_FAST:
+        if ((conn = client_connect (client))) {
+          client->dropped = !client_read (client, conn, 0, deadline);
+          gst_unix_client_close (conn);
+        }
+        /* a healthy client that got dropped is a failure, no retry */
+        client_wait (deadline);
+        break;
+      case BEHAVIOR_SLOW:
+        if ((conn = client_connect (client))) {
+          if (!client_read (client, conn, slow_delay * GST_MSECOND, deadline))
+            client->dropped = TRUE;
+          gst_unix_client_close (conn);
+        } else {
+          client_wait (gst_unix_latency_now () + POLL_INTERVAL);
+        }
+        break;
+      case BEHAVIOR_STALLED:
+        if ((conn = client_connect (client))) {
+          client_wait (deadline);
+          gst_unix_client_close (conn);
+        } else {
+          client_wait (gst_unix_latency_now () + POLL_INTERVAL);
+        }
+        break;
+      case BEHAVIOR_FLAPPING:
+        if ((conn = client_connect (client))) {
+          client_read (client, conn, 0,
+              gst_unix_latency_now () + flap_interval * GST_MSECOND);
+          gst_unix_client_close (conn);
+        } else {
+          client_wait (gst_unix_latency_now () + POLL_INTERVAL);
+        }
+        break;
+      case BEHAVIOR_HALF_OPEN:
+        client_half_open (client);
+        break;
+      default:
+        g_assert_not_reached ();
+    }
+  }
+
+  return NULL;
+}
+
+/* share of every behavior in percent */
+static gboolean
+parse_mix (const gchar * str, guint shares[N_BEHAVIORS])
+{
+  gchar **parts;
+  guint i, j, total = 0;
+  gboolean ret = TRUE;
+
+  memset (shares, 0, N_BEHAVIORS * sizeof (guint));
+
+  parts = g_strsplit (str, ",", -1);
+  for (i = 0; parts[i] && ret; i++) {
+    gchar **kv = g_strsplit (parts[i], "=", 2);
+
+    ret = FALSE;
+    for (j = 0; j < N_BEHAVIORS && kv[0] && kv[1]; j++) {
+      if (strcmp (kv[0], behavior_names[j]) == 0) {
+        shares[j] = atoi (kv[1]);
+        total += shares[j];
+        ret = TRUE;
+      }
+    }
+    g_strfreev (kv);
+  }
+  g_strfreev (parts);
+
+  return ret && total > 0;
+}
+
+static void
+add_failure (GString * failures, const gchar * format, ...)
+{
+  va_list args;
+
+  if (failures->len > 0)
+    g_string_append (failures, ", ");
+  g_string_append_c (failures, '"');
+  va_start (args, format);
+  g_string_append_vprintf (failures, format, args);
+  va_end (args);
+  g_string_append_c (failures, '"');
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GstElement *pipeline, *sink;
+  GstStructure *stats;
+  GstPad *pad;
+  GstBus *bus;
+  GstMessage *msg;
+  GstClock *clock;
+  GError *err = NULL;
+  SoakClient *clients;
+  GString *json, *failures;
+  guint shares[N_BEHAVIORS], total = 0;
+  guint fds_before, fds_running, fds_settled, fds_after;
+  gsize rss_base, rss_peak, rss_settled;
+  guint64 accepted = 0, rejected = 0;
+  gint start_bytes, end_bytes, stream_bytes;
+  gchar *desc, *tmpdir = NULL;
+  guint i, b;
+  gboolean unlinked, passed;
+
+  ctx = g_option_context_new ("- soak test unixserversink");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    return 2;
+  }
+  g_option_context_free (ctx);
+
+  /* a directory of our own, so parallel runs do not remove each other's
+   * socket */
+  if (!path) {
+    tmpdir = g_dir_make_tmp ("gst-unix-soak-XXXXXX", &err);
+    if (!tmpdir) {
+      g_printerr ("%s\n", err->message);
+      return 2;
+    }
+    path = g_build_filename (tmpdir, "soak.sock", NULL);
+  }
+  if (!mix)
+    mix = g_strdup ("fast=50,slow=20,stalled=10,flapping=15,half-open=5");
+  if (!source)
+    source = g_strdup ("videotestsrc is-live=true ! "
+        "video/x-raw,width=320,height=240,framerate=30/1");
+  if (!sink_properties)
+    sink_properties = g_strdup ("units-max=300 timeout=5000000000");
+
+  if (!parse_mix (mix, shares) || n_clients <= 0 || duration <= 0) {
+    g_printerr ("need a valid --mix, --clients and --duration\n");
+    return 2;
+  }
+  for (b = 0; b < N_BEHAVIORS; b++)
+    total += shares[b];
+
+  /* the system clock keeps its timer fds for the life of the process */
+  clock = gst_system_clock_obtain ();
+  fds_before = count_fds ();
+
+  if (!tmpdir)
+    g_unlink (path);
+  desc = g_strdup_printf ("%s ! unixserversink name=sink protocol=framed "
+      "send-timestamps=true path=%s %s", source, path, sink_properties);
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("%s\n", err->message);
+    return 2;
+  }
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, count_bytes, NULL, NULL);
+  gst_object_unref (pad);
+  bus = gst_element_get_bus (pipeline);
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE ||
+      gst_element_get_state (pipeline, NULL, NULL,
+          5 * GST_SECOND) == GST_STATE_CHANGE_FAILURE) {
+    g_printerr ("could not start the pipeline\n");
+    return 2;
+  }
+
+  /* warm up before taking the baseline */
+  g_usleep (G_USEC_PER_SEC);
+  fds_running = count_fds ();
+  rss_base = rss_peak = read_rss ();
+
+  clients = g_new0 (SoakClient, n_clients);
+  deadline = gst_unix_latency_now () + duration * GST_SECOND;
+  start_bytes = g_atomic_int_get (&sink_bytes);
+  for (i = 0; i < (guint) n_clients; i++) {
+    guint slot = i * total / n_clients, sum = 0;
+
+    /* spread the behaviors over the clients by their share */
+    for (b = 0; b < N_BEHAVIORS - 1 && slot >= sum + shares[b]; b++)
+      sum += shares[b];
+
+    clients[i].index = i;
+    clients[i].behavior = b;
+    clients[i].stream_start = -1;
+    gst_unix_histogram_reset (&clients[i].latency);
+    clients[i].thread = g_thread_new ("soak-client", client_thread,
+        &clients[i]);
+  }
+
+  /* sample the resident set until the clients are done */
+  while (gst_unix_latency_now () < deadline) {
+    msg = gst_bus_timed_pop_filtered (bus, GST_SECOND,
+        GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+    if (msg) {
+      if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+        gst_message_parse_error (msg, &err, NULL);
+        g_printerr ("pipeline error: %s\n", err->message);
+        g_clear_error (&err);
+      }
+      gst_message_unref (msg);
+      break;
+    }
+    rss_peak = MAX (rss_peak, read_rss ());
+  }
+  end_bytes = g_atomic_int_get (&sink_bytes);
+  stream_bytes = end_bytes - start_bytes;
+
+  for (i = 0; i < (guint) n_clients; i++)
+    g_thread_join (clients[i].thread);
+
+  /* the sink only notices a closed client when it next looks at it */
+  g_usleep (settle * G_USEC_PER_SEC);
+  fds_settled = count_fds ();
+  rss_settled = read_rss ();
+
+  g_object_get (sink, "stats", &stats, NULL);
+  gst_structure_get_uint64 (stats, "clients-accepted", &accepted);
+  gst_structure_get_uint64 (stats, "clients-rejected", &rejected);
+  gst_structure_free (stats);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+  unlinked = !g_file_test (path, G_FILE_TEST_EXISTS);
+  fds_after = count_fds ();
+  gst_object_unref (clock);
+  if (tmpdir)
+    g_rmdir (tmpdir);
+
+  /* checks */
+  failures = g_string_new (NULL);
+  if (rss_settled > rss_base + max_rss_growth)
+    add_failure (failures, "resident set grew by %" G_GSIZE_FORMAT " KiB",
+        rss_settled - rss_base);
+  if (fds_settled > fds_running)
+    add_failure (failures, "%u fds leaked", fds_settled - fds_running);
+  if (fds_after > fds_before)
+    add_failure (failures, "%u fds left after stopping",
+        fds_after - fds_before);
+  if (!unlinked)
+    add_failure (failures, "socket %s not removed", path);
+
+  json = g_string_new ("{");
+  g_string_append_printf (json, "\"duration\": %d, \"clients\": %d, "
+      "\"stream-kib\": %d, \"clients-accepted\": %" G_GUINT64_FORMAT
+      ", \"clients-rejected\": %" G_GUINT64_FORMAT ", ", duration,
+      n_clients, stream_bytes, accepted, rejected);
+  g_string_append_printf (json, "\"rss-baseline-kib\": %" G_GSIZE_FORMAT
+      ", \"rss-peak-kib\": %" G_GSIZE_FORMAT ", \"rss-settled-kib\": %"
+      G_GSIZE_FORMAT ", ", rss_base, rss_peak, rss_settled);
+  g_string_append_printf (json, "\"fds-before\": %u, \"fds-running\": %u, "
+      "\"fds-settled\": %u, \"fds-after-stop\": %u, \"socket-removed\": %s",
+      fds_before, fds_running, fds_settled, fds_after,
+      unlinked ? "true" : "false");
+
+  for (b = 0; b < N_BEHAVIORS; b++) {
+    GstUNIXHistogram latency;
+    guint count = 0, dropped = 0;
+    guint64 frames = 0, bytes = 0, connects = 0, errors = 0;
+    guint64 worst_p99 = 0;
+    gdouble worst_ratio = 1.0;
+
+    gst_unix_histogram_reset (&latency);
+    for (i = 0; i < (guint) n_clients; i++) {
+      SoakClient *client = &clients[i];
+      gdouble ratio;
+
+      if (client->behavior != b)
+        continue;
+
+      count++;
+      frames += client->frames;
+      bytes += client->bytes;
+      connects += client->connects;
+      errors += client->errors;
+      dropped += client->dropped;
+      histogram_merge (&latency, &client->latency);
+      worst_p99 = MAX (worst_p99,
+          gst_unix_histogram_percentile (&client->latency, 99.0));
+      ratio = client->stream_start >= 0 && end_bytes > client->stream_start ?
+          (client->share_bytes / 1024.0) / (end_bytes -
+          client->stream_start) : 0.0;
+      worst_ratio = MIN (worst_ratio, ratio);
+
+      if (b != BEHAVIOR_FAST)
+        continue;
+      if (client->dropped)
+        add_failure (failures, "fast client %u was dropped", i);
+      else if (ratio < min_throughput)
+        add_failure (failures, "fast client %u got %.3f of the stream", i,
+            ratio);
+      if (gst_unix_histogram_percentile (&client->latency, 99.0) >
+          (guint64) max_latency * GST_MSECOND)
+        add_failure (failures, "fast client %u p99 latency %" G_GUINT64_FORMAT
+            " us", i, gst_unix_histogram_percentile (&client->latency,
+                99.0) / 1000);
+    }
+
+    g_string_append_printf (json, ", \"%s\": {\"clients\": %u, "
+        "\"frames\": %" G_GUINT64_FORMAT ", \"bytes\": %" G_GUINT64_FORMAT
+        ", \"connects\": %" G_GUINT64_FORMAT ", \"errors\": %"
+        G_GUINT64_FORMAT ", \"dropped\": %u, \"min-share\": %.4f, "
+        "\"latency-p50-us\": %" G_GUINT64_FORMAT ", \"latency-p99-us\": %"
+        G_GUINT64_FORMAT ", \"latency-max-us\": %" G_GUINT64_FORMAT
+        ", \"latency-worst-p99-us\": %" G_GUINT64_FORMAT "}",
+        behavior_names[b], count, frames, bytes, connects, errors, dropped,
+        count ? worst_ratio : 0.0,
+        gst_unix_histogram_percentile (&latency, 50.0) / 1000,
+        gst_unix_histogram_percentile (&latency, 99.0) / 1000,
+        latency.max / 1000, worst_p99 / 1000);
+  }
+
+  g_string_append_printf (json, ", \"failures\": [%s], \"passed\": %s}",
+      failures->str, failures->len ? "false" : "true");
+  g_print ("%s\n", json->str);
+
+  passed = failures->len == 0;
+  g_string_free (json, TRUE);
+  g_string_free (failures, TRUE);
+  g_free (clients);
+  g_free (tmpdir);
+
+  return passed ? 0 : 1;
+}
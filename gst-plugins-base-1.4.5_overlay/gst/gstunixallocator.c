@@ -0,0 +1,229 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Allocator for received buffers. Small allocations come from
+ * posix_memalign, allocations of at least GST_UNIX_HUGE_PAGE_SIZE are
+ * mmapped and backed by huge pages to cut TLB pressure on large video
+ * frames. Alignment is taken from the GstAllocationParams. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "gstunixallocator.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+typedef struct
+{
+  GstMemory mem;
+
+  guint8 *data;
+  /* what was allocated, NULL for shared sub memories */
+  gpointer base;
+  gsize base_size;
+  gboolean mapped;
+} GstUNIXMemory;
+
+GType
+gst_unix_huge_pages_get_type (void)
+{
+  static GType unix_huge_pages_type = 0;
+  static const GEnumValue unix_huge_pages[] = {
+    {GST_UNIX_HUGE_PAGES_NONE, "Regular pages", "none"},
+    {GST_UNIX_HUGE_PAGES_TRANSPARENT, "Transparent huge pages", "transparent"},
+    {GST_UNIX_HUGE_PAGES_EXPLICIT, "Explicit hugetlb pages", "explicit"},
+    {0, NULL, NULL},
+  };
+
+  if (!unix_huge_pages_type) {
+    unix_huge_pages_type =
+        g_enum_register_static ("GstUNIXHugePages", unix_huge_pages);
+  }
+  return unix_huge_pages_type;
+}
+
+#define gst_unix_allocator_parent_class parent_class
+G_DEFINE_TYPE (GstUNIXAllocator, gst_unix_allocator, GST_TYPE_ALLOCATOR);
+
+/* map @size bytes with huge pages, NULL when that is not possible */
+static gpointer
+gst_unix_allocator_map_huge (GstUNIXAllocator * allocator, gsize size)
+{
+  gpointer base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (allocator->huge_pages == GST_UNIX_HUGE_PAGES_EXPLICIT) {
+    base = mmap (NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base == MAP_FAILED)
+      GST_DEBUG ("hugetlb pool exhausted, using transparent huge pages");
+  }
+#endif
+
+  if (base == MAP_FAILED) {
+    base = mmap (NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+      return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise (base, size, MADV_HUGEPAGE);
+#endif
+  }
+
+  return base;
+}
+
+static GstMemory *
+gst_unix_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstUNIXAllocator *self = GST_UNIX_ALLOCATOR (allocator);
+  GstUNIXMemory *mem;
+  gsize maxsize, align;
+
+  maxsize = size + params->prefix + params->padding;
+  align = params->align | gst_memory_alignment;
+
+  mem = g_slice_new (GstUNIXMemory);
+  mem->base = NULL;
+  mem->mapped = FALSE;
+
+  if (self->huge_pages != GST_UNIX_HUGE_PAGES_NONE &&
+      maxsize >= GST_UNIX_HUGE_PAGE_SIZE && align < GST_UNIX_HUGE_PAGE_SIZE) {
+    /* mmap returns page aligned memory, more than any alignment asked for */
+    mem->base_size = GST_ROUND_UP_N (maxsize, GST_UNIX_HUGE_PAGE_SIZE);
+    mem->base = gst_unix_allocator_map_huge (self, mem->base_size);
+    mem->mapped = (mem->base != NULL);
+  }
+
+  if (!mem->base) {
+    mem->base_size = maxsize;
+    if (posix_memalign (&mem->base, MAX (align + 1, sizeof (gpointer)),
+            maxsize) != 0) {
+      g_slice_free (GstUNIXMemory, mem);
+      return NULL;
+    }
+  }
+  mem->data = mem->base;
+
+  gst_memory_init (GST_MEMORY_CAST (mem), params->flags, allocator, NULL,
+      maxsize, align, params->prefix, size);
+
+  return GST_MEMORY_CAST (mem);
+}
+
+static void
+gst_unix_allocator_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstUNIXMemory *mem = (GstUNIXMemory *) memory;
+
+  if (mem->base) {
+    if (mem->mapped)
+      munmap (mem->base, mem->base_size);
+    else
+      free (mem->base);
+  }
+  g_slice_free (GstUNIXMemory, mem);
+}
+
+static gpointer
+gst_unix_memory_map (GstUNIXMemory * mem, gsize maxsize, GstMapFlags flags)
+{
+  return mem->data;
+}
+
+static void
+gst_unix_memory_unmap (GstUNIXMemory * mem)
+{
+}
+
+static GstUNIXMemory *
+gst_unix_memory_share (GstUNIXMemory * mem, gssize offset, gsize size)
+{
+  GstUNIXMemory *sub;
+  GstMemory *parent;
+
+  if ((parent = mem->mem.parent) == NULL)
+    parent = GST_MEMORY_CAST (mem);
+
+  if (size == (gsize) - 1)
+    size = mem->mem.size - offset;
+
+  sub = g_slice_new (GstUNIXMemory);
+  gst_memory_init (GST_MEMORY_CAST (sub),
+      GST_MINI_OBJECT_FLAGS (parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+      mem->mem.allocator, parent, mem->mem.maxsize, mem->mem.align,
+      mem->mem.offset + offset, size);
+  sub->data = mem->data;
+  sub->base = NULL;
+  sub->base_size = 0;
+  sub->mapped = FALSE;
+
+  return sub;
+}
+
+static gboolean
+gst_unix_memory_is_span (GstUNIXMemory * mem1, GstUNIXMemory * mem2,
+    gsize * offset)
+{
+  if (offset)
+    *offset = mem1->mem.offset;
+
+  return mem1->data == mem2->data &&
+      mem1->mem.offset + mem1->mem.size == mem2->mem.offset;
+}
+
+static void
+gst_unix_allocator_class_init (GstUNIXAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_unix_allocator_alloc;
+  allocator_class->free = gst_unix_allocator_free;
+}
+
+static void
+gst_unix_allocator_init (GstUNIXAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = GST_UNIX_ALLOCATOR_NAME;
+  alloc->mem_map = (GstMemoryMapFunction) gst_unix_memory_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) gst_unix_memory_unmap;
+  alloc->mem_share = (GstMemoryShareFunction) gst_unix_memory_share;
+  alloc->mem_is_span = (GstMemoryIsSpanFunction) gst_unix_memory_is_span;
+
+  allocator->huge_pages = GST_UNIX_HUGE_PAGES_NONE;
+}
+
+GstAllocator *
+gst_unix_allocator_new (GstUNIXHugePages huge_pages)
+{
+  GstUNIXAllocator *allocator;
+
+  allocator = g_object_new (GST_TYPE_UNIX_ALLOCATOR, NULL);
+  allocator->huge_pages = huge_pages;
+
+  return GST_ALLOCATOR_CAST (allocator);
+}
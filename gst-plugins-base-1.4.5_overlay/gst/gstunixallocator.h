@@ -0,0 +1,79 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_ALLOCATOR_H__
+#define __GST_UNIX_ALLOCATOR_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_UNIX_ALLOCATOR_NAME      "UNIXMemory"
+
+/* allocations of at least this size are backed by huge pages */
+#define GST_UNIX_HUGE_PAGE_SIZE      (2 * 1024 * 1024)
+
+#define GST_TYPE_UNIX_HUGE_PAGES (gst_unix_huge_pages_get_type())
+
+/**
+ * GstUNIXHugePages:
+ * @GST_UNIX_HUGE_PAGES_NONE: regular pages
+ * @GST_UNIX_HUGE_PAGES_TRANSPARENT: ask for transparent huge pages with
+ *   madvise(MADV_HUGEPAGE)
+ * @GST_UNIX_HUGE_PAGES_EXPLICIT: map from the hugetlb pool with
+ *   MAP_HUGETLB, falling back to transparent huge pages when the pool is
+ *   exhausted
+ *
+ * How large allocations are backed.
+ */
+typedef enum {
+  GST_UNIX_HUGE_PAGES_NONE,
+  GST_UNIX_HUGE_PAGES_TRANSPARENT,
+  GST_UNIX_HUGE_PAGES_EXPLICIT
+} GstUNIXHugePages;
+
+#define GST_TYPE_UNIX_ALLOCATOR \
+  (gst_unix_allocator_get_type())
+#define GST_UNIX_ALLOCATOR(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UNIX_ALLOCATOR,GstUNIXAllocator))
+#define GST_IS_UNIX_ALLOCATOR(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_UNIX_ALLOCATOR))
+
+typedef struct _GstUNIXAllocator GstUNIXAllocator;
+typedef struct _GstUNIXAllocatorClass GstUNIXAllocatorClass;
+
+struct _GstUNIXAllocator {
+  GstAllocator parent;
+
+  GstUNIXHugePages huge_pages;
+};
+
+struct _GstUNIXAllocatorClass {
+  GstAllocatorClass parent_class;
+};
+
+GType         gst_unix_huge_pages_get_type (void);
+GType         gst_unix_allocator_get_type  (void);
+
+GstAllocator *gst_unix_allocator_new       (GstUNIXHugePages huge_pages);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_ALLOCATOR_H__ */
@@ -0,0 +1,206 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Capture of the bytes a unixclientsrc reads from its socket, with the time
+ * and size of every read, for replaying the exact traffic pattern later.
+ * Writing goes through stdio buffering so recording costs a copy per read;
+ * reading maps the file and hands out pointers into it. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#include "gstunixcapture.h"
+#include "gstunixlatency.h"
+
+G_STATIC_ASSERT (sizeof (GstUNIXCaptureHeader) == 32);
+G_STATIC_ASSERT (sizeof (GstUNIXCaptureRecord) == 16);
+
+#define GST_UNIX_CAPTURE_PAD(size) (((size) + 7) & ~((gsize) 7))
+
+struct _GstUNIXCapture
+{
+  FILE *file;
+  GstClockTime start_time;
+};
+
+struct _GstUNIXCaptureFile
+{
+  GMappedFile *mapped;
+  const guint8 *data;
+  gsize size;
+};
+
+GstUNIXCapture *
+gst_unix_capture_new (const gchar * location, GstUNIXCaptureFlags flags,
+    GError ** error)
+{
+  GstUNIXCaptureHeader header;
+  GstUNIXCapture *capture;
+  FILE *file;
+
+  file = g_fopen (location, "wb");
+  if (!file)
+    goto open_failed;
+
+  memset (&header, 0, sizeof (header));
+  strcpy (header.magic, GST_UNIX_CAPTURE_MAGIC);
+  header.version = GST_UNIX_CAPTURE_VERSION;
+  header.flags = flags;
+  header.start_time = gst_unix_latency_now ();
+
+  if (fwrite (&header, sizeof (header), 1, file) != 1)
+    goto write_failed;
+
+  capture = g_slice_new (GstUNIXCapture);
+  capture->file = file;
+  capture->start_time = header.start_time;
+
+  return capture;
+
+  /* ERRORS */
+open_failed:
+  {
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+        "Could not open %s: %s", location, g_strerror (errno));
+    return NULL;
+  }
+write_failed:
+  {
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+        "Could not write %s: %s", location, g_strerror (errno));
+    fclose (file);
+    return NULL;
+  }
+}
+
+void
+gst_unix_capture_free (GstUNIXCapture * capture)
+{
+  fclose (capture->file);
+  g_slice_free (GstUNIXCapture, capture);
+}
+
+/* record a read of @size bytes that just returned. On failure the file
+ * ends with a truncated record, which playback stops at */
+gboolean
+gst_unix_capture_write (GstUNIXCapture * capture, gconstpointer data,
+    gsize size, GError ** error)
+{
+  static const guint8 padding[8] = { 0, };
+  GstUNIXCaptureRecord record;
+  gsize pad = GST_UNIX_CAPTURE_PAD (size) - size;
+
+  record.time = gst_unix_latency_now () - capture->start_time;
+  record.size = size;
+  record.reserved = 0;
+
+  if (fwrite (&record, sizeof (record), 1, capture->file) != 1 ||
+      fwrite (data, 1, size, capture->file) != size ||
+      fwrite (padding, 1, pad, capture->file) != pad)
+    goto write_failed;
+
+  return TRUE;
+
+  /* ERRORS */
+write_failed:
+  {
+    g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+        "Could not write capture: %s", g_strerror (errno));
+    return FALSE;
+  }
+}
+
+GstUNIXCaptureFile *
+gst_unix_capture_file_open (const gchar * location, GError ** error)
+{
+  GstUNIXCaptureFile *file;
+  const GstUNIXCaptureHeader *header;
+  GMappedFile *mapped;
+
+  mapped = g_mapped_file_new (location, FALSE, error);
+  if (!mapped)
+    return NULL;
+
+  header = (const GstUNIXCaptureHeader *) g_mapped_file_get_contents (mapped);
+  if (g_mapped_file_get_length (mapped) < sizeof (GstUNIXCaptureHeader) ||
+      memcmp (header->magic, GST_UNIX_CAPTURE_MAGIC,
+          sizeof (GST_UNIX_CAPTURE_MAGIC)) != 0 ||
+      header->version != GST_UNIX_CAPTURE_VERSION)
+    goto invalid;
+
+  file = g_slice_new (GstUNIXCaptureFile);
+  file->mapped = mapped;
+  file->data = (const guint8 *) header;
+  file->size = g_mapped_file_get_length (mapped);
+
+  return file;
+
+  /* ERRORS */
+invalid:
+  {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s is not a UNIX transport capture", location);
+    g_mapped_file_unref (mapped);
+    return NULL;
+  }
+}
+
+void
+gst_unix_capture_file_close (GstUNIXCaptureFile * file)
+{
+  g_mapped_file_unref (file->mapped);
+  g_slice_free (GstUNIXCaptureFile, file);
+}
+
+const GstUNIXCaptureHeader *
+gst_unix_capture_file_get_header (GstUNIXCaptureFile * file)
+{
+  return (const GstUNIXCaptureHeader *) file->data;
+}
+
+/* get the record at @offset and advance it, 0 is the first record. Returns
+ * FALSE at the end or on a truncated record */
+gboolean
+gst_unix_capture_file_next (GstUNIXCaptureFile * file, gsize * offset,
+    const GstUNIXCaptureRecord ** record, const guint8 ** data)
+{
+  gsize pos = MAX (*offset, sizeof (GstUNIXCaptureHeader));
+  const GstUNIXCaptureRecord *rec;
+
+  /* the padding of the last record may be missing */
+  if (pos > file->size || file->size - pos < sizeof (GstUNIXCaptureRecord))
+    return FALSE;
+
+  rec = (const GstUNIXCaptureRecord *) (file->data + pos);
+  pos += sizeof (GstUNIXCaptureRecord);
+  if (file->size - pos < rec->size)
+    return FALSE;
+
+  *record = rec;
+  *data = file->data + pos;
+  *offset = pos + GST_UNIX_CAPTURE_PAD (rec->size);
+
+  return TRUE;
+}
@@ -0,0 +1,95 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_CAPTURE_H__
+#define __GST_UNIX_CAPTURE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_UNIX_CAPTURE_MAGIC          "GSTUCAP"
+#define GST_UNIX_CAPTURE_VERSION        1
+
+typedef enum {
+  GST_UNIX_CAPTURE_FLAG_FRAMED  = (1 << 0)
+} GstUNIXCaptureFlags;
+
+typedef struct _GstUNIXCaptureHeader GstUNIXCaptureHeader;
+typedef struct _GstUNIXCaptureRecord GstUNIXCaptureRecord;
+typedef struct _GstUNIXCapture GstUNIXCapture;
+typedef struct _GstUNIXCaptureFile GstUNIXCaptureFile;
+
+/**
+ * GstUNIXCaptureHeader:
+ * @magic: #GST_UNIX_CAPTURE_MAGIC, NUL terminated
+ * @version: #GST_UNIX_CAPTURE_VERSION
+ * @flags: #GstUNIXCaptureFlags
+ * @start_time: CLOCK_MONOTONIC time at which the capture started
+ *
+ * Start of a capture file. It is followed by records, each one a
+ * #GstUNIXCaptureRecord and its data padded to 8 bytes, so a mapped file
+ * can be walked without copying.
+ */
+struct _GstUNIXCaptureHeader {
+  gchar magic[8];
+  guint32 version;
+  guint32 flags;
+  guint64 start_time;
+  guint64 reserved;
+};
+
+/**
+ * GstUNIXCaptureRecord:
+ * @time: arrival time of the data, relative to @start_time
+ * @size: number of bytes returned by the read
+ *
+ * One read from the socket.
+ */
+struct _GstUNIXCaptureRecord {
+  guint64 time;
+  guint32 size;
+  guint32 reserved;
+};
+
+/* recording, used by unixclientsrc */
+GstUNIXCapture     *gst_unix_capture_new        (const gchar * location,
+                                                 GstUNIXCaptureFlags flags,
+                                                 GError ** error);
+void                gst_unix_capture_free       (GstUNIXCapture * capture);
+gboolean            gst_unix_capture_write      (GstUNIXCapture * capture,
+                                                 gconstpointer data,
+                                                 gsize size,
+                                                 GError ** error);
+
+/* playback */
+GstUNIXCaptureFile *gst_unix_capture_file_open  (const gchar * location,
+                                                 GError ** error);
+void                gst_unix_capture_file_close (GstUNIXCaptureFile * file);
+const GstUNIXCaptureHeader *
+                    gst_unix_capture_file_get_header (GstUNIXCaptureFile * file);
+gboolean            gst_unix_capture_file_next  (GstUNIXCaptureFile * file,
+                                                 gsize * offset,
+                                                 const GstUNIXCaptureRecord ** record,
+                                                 const guint8 ** data);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_CAPTURE_H__ */
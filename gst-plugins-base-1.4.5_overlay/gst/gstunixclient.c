@@ -0,0 +1,516 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Standalone client library, see gstunixclient.h. Deliberately plain libc:
+ * no GLib, no GStreamer. Every receiving function keeps its progress in the
+ * client, so with a nonblocking socket a call interrupted by EAGAIN resumes
+ * on the next one. Only streams of a single connection are supported, no
+ * stripes. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "gstunixclientwire.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct _GstUNIXClient
+{
+  int fd;
+  int framed;
+
+  /* message being received */
+  GstUNIXClientHeader header;
+  size_t header_done;
+  uint32_t remaining;           /* payload bytes not read yet */
+
+  /* the current buffer, its header was returned and its payload is read */
+  int in_buffer;
+  GstUNIXClientFrame frame;
+
+  char *caps;
+  char *pending_caps;           /* caps message being received */
+  int caps_changed;
+};
+
+struct _GstUNIXClientPool
+{
+  pthread_mutex_t lock;
+  size_t slot_size;
+  size_t stride;
+  unsigned int n_slots;
+  unsigned char *memory;
+  void **free_slots;            /* protected by lock */
+  unsigned int n_free;          /* protected by lock */
+};
+
+static ssize_t
+gst_unix_client_recv (GstUNIXClient * client, void *data, size_t size)
+{
+  ssize_t ret;
+
+  do {
+    ret = recv (client->fd, data, size, 0);
+  } while (ret < 0 && errno == EINTR);
+
+  return ret;
+}
+
+/* like gst_unix_client_recv(), but the end of the stream is an error */
+static ssize_t
+gst_unix_client_recv_more (GstUNIXClient * client, void *data, size_t size)
+{
+  ssize_t ret = gst_unix_client_recv (client, data, size);
+
+  if (ret == 0) {
+    errno = ECONNRESET;
+    return -1;
+  }
+  return ret;
+}
+
+static int
+gst_unix_client_send_all (int fd, const void *data, size_t size)
+{
+  const char *ptr = data;
+
+  while (size > 0) {
+    ssize_t ret = send (fd, ptr, size, MSG_NOSIGNAL);
+
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    ptr += ret;
+    size -= ret;
+  }
+  return 0;
+}
+
+/* the hello is a serialized GstStructure */
+static int
+gst_unix_client_send_hello (int fd, const char *rendition)
+{
+  GstUNIXClientHeader header;
+  size_t len;
+  char *str, *p;
+  int ret, errsv;
+
+  len = sizeof ("hello, rendition=(string)\"\";");
+  if (rendition)
+    len += 2 * strlen (rendition);
+  if (!(str = malloc (len))) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  p = str + sprintf (str, "hello");
+  if (rendition) {
+    p += sprintf (p, ", rendition=(string)\"");
+    for (; *rendition; rendition++) {
+      if (*rendition == '"' || *rendition == '\\')
+        *p++ = '\\';
+      *p++ = *rendition;
+    }
+    *p++ = '"';
+  }
+  strcpy (p, ";");
+
+  len = strlen (str) + 1;
+  if (len > GST_UNIX_CLIENT_MAX_CAPS) {
+    free (str);
+    errno = EINVAL;
+    return -1;
+  }
+
+  memset (&header, 0, sizeof (header));
+  header.magic = GST_UNIX_CLIENT_MAGIC;
+  header.version = GST_UNIX_CLIENT_VERSION;
+  header.type = GST_UNIX_CLIENT_MESSAGE_HELLO;
+  header.size = len;
+  header.total_size = len;
+  header.pts = GST_UNIX_CLIENT_TIME_NONE;
+  header.duration = GST_UNIX_CLIENT_TIME_NONE;
+
+  ret = gst_unix_client_send_all (fd, &header, sizeof (header));
+  if (ret == 0)
+    ret = gst_unix_client_send_all (fd, str, len);
+  errsv = errno;
+  free (str);
+  errno = errsv;
+
+  return ret;
+}
+
+GstUNIXClient *
+gst_unix_client_connect (const char *path,
+    const GstUNIXClientOptions * options)
+{
+  GstUNIXClientOptions defaults = { 0, 0, NULL };
+  struct sockaddr_un addr;
+  GstUNIXClient *client;
+  int fd, flags, errsv;
+
+  if (!options)
+    options = &defaults;
+
+  if (strlen (path) >= sizeof (addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return NULL;
+  }
+
+  fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return NULL;
+  fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+  if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    goto failed;
+
+  if (options->framed && gst_unix_client_send_hello (fd, options->rendition))
+    goto failed;
+
+  if (options->nonblocking) {
+    flags = fcntl (fd, F_GETFL);
+    if (flags < 0 || fcntl (fd, F_SETFL, flags | O_NONBLOCK) < 0)
+      goto failed;
+  }
+
+  if (!(client = calloc (1, sizeof (GstUNIXClient)))) {
+    errno = ENOMEM;
+    goto failed;
+  }
+  client->fd = fd;
+  client->framed = options->framed;
+
+  return client;
+
+failed:
+  errsv = errno;
+  close (fd);
+  errno = errsv;
+  return NULL;
+}
+
+void
+gst_unix_client_close (GstUNIXClient * client)
+{
+  close (client->fd);
+  free (client->caps);
+  free (client->pending_caps);
+  free (client);
+}
+
+int
+gst_unix_client_get_fd (GstUNIXClient * client)
+{
+  return client->fd;
+}
+
+/* NULL until the server announced caps */
+const char *
+gst_unix_client_get_caps (GstUNIXClient * client)
+{
+  return client->caps;
+}
+
+/* read the payload of the caps message whose header was received */
+static int
+gst_unix_client_read_caps (GstUNIXClient * client)
+{
+  uint32_t size = client->header.size;
+  ssize_t ret;
+
+  if (!client->pending_caps) {
+    if (!(client->pending_caps = malloc (size))) {
+      errno = ENOMEM;
+      return -1;
+    }
+    client->remaining = size;
+  }
+
+  while (client->remaining > 0) {
+    ret = gst_unix_client_recv_more (client,
+        client->pending_caps + size - client->remaining, client->remaining);
+    if (ret < 0)
+      return -1;
+    client->remaining -= ret;
+  }
+  client->pending_caps[size - 1] = '\0';
+
+  free (client->caps);
+  client->caps = client->pending_caps;
+  client->pending_caps = NULL;
+  client->caps_changed = 1;
+
+  return 0;
+}
+
+/* drop what is left of the current buffer */
+static int
+gst_unix_client_skip (GstUNIXClient * client)
+{
+  char scratch[4096];
+  ssize_t ret;
+
+  while (client->remaining > 0) {
+    ret = gst_unix_client_recv_more (client, scratch,
+        client->remaining < sizeof (scratch) ?
+        client->remaining : sizeof (scratch));
+    if (ret < 0)
+      return -1;
+    client->remaining -= ret;
+  }
+  client->in_buffer = 0;
+
+  return 0;
+}
+
+int
+gst_unix_client_next (GstUNIXClient * client, GstUNIXClientFrame * frame)
+{
+  GstUNIXClientHeader *header = &client->header;
+  ssize_t ret;
+
+  if (!client->framed) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (client->in_buffer && gst_unix_client_skip (client) < 0)
+    return -1;
+
+  while (1) {
+    while (client->header_done < sizeof (GstUNIXClientHeader)) {
+      ret = gst_unix_client_recv (client,
+          (char *) header + client->header_done,
+          sizeof (GstUNIXClientHeader) - client->header_done);
+      if (ret < 0)
+        return -1;
+      if (ret == 0) {
+        if (client->header_done == 0)
+          return 0;
+        errno = ECONNRESET;
+        return -1;
+      }
+      client->header_done += ret;
+    }
+
+    if (header->magic != GST_UNIX_CLIENT_MAGIC ||
+        header->version != GST_UNIX_CLIENT_VERSION ||
+        header->offset != 0 || header->size != header->total_size)
+      goto invalid;
+
+    if (header->type == GST_UNIX_CLIENT_MESSAGE_BUFFER)
+      break;
+
+    /* the server converts for us and tells us the format */
+    if (header->type != GST_UNIX_CLIENT_MESSAGE_CAPS || header->size == 0 ||
+        header->size > GST_UNIX_CLIENT_MAX_CAPS)
+      goto invalid;
+    if (gst_unix_client_read_caps (client) < 0)
+      return -1;
+    client->header_done = 0;
+  }
+
+  client->frame.seq = header->seq;
+  client->frame.pts = header->pts;
+  client->frame.duration = header->duration;
+  client->frame.send_time = header->send_time;
+  client->frame.flags = header->flags;
+  client->frame.size = header->size;
+  client->frame.caps_changed = client->caps_changed;
+  client->caps_changed = 0;
+  client->remaining = header->size;
+  client->in_buffer = 1;
+  client->header_done = 0;
+
+  *frame = client->frame;
+
+  return 1;
+
+invalid:
+  errno = EPROTO;
+  return -1;
+}
+
+ssize_t
+gst_unix_client_read (GstUNIXClient * client, void *data, size_t size)
+{
+  ssize_t ret;
+
+  if (!client->framed)
+    return gst_unix_client_recv (client, data, size);
+
+  if (!client->in_buffer || size == 0)
+    return 0;
+
+  if (client->remaining == 0) {
+    client->in_buffer = 0;
+    return 0;
+  }
+
+  ret = gst_unix_client_recv_more (client, data,
+      size < client->remaining ? size : client->remaining);
+  if (ret < 0)
+    return -1;
+
+  client->remaining -= ret;
+  if (client->remaining == 0)
+    client->in_buffer = 0;
+
+  return ret;
+}
+
+int
+gst_unix_client_receive (GstUNIXClient * client, GstUNIXClientFrame * frame,
+    void *data, size_t size)
+{
+  int ret;
+
+  if (!client->in_buffer) {
+    if ((ret = gst_unix_client_next (client, frame)) <= 0)
+      return ret;
+  } else {
+    *frame = client->frame;
+  }
+
+  if (frame->size > size) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  /* resumes behind what an earlier call already received */
+  while (client->remaining > 0) {
+    if (gst_unix_client_read (client,
+            (char *) data + frame->size - client->remaining,
+            client->remaining) < 0)
+      return -1;
+  }
+  client->in_buffer = 0;
+
+  return 1;
+}
+
+GstUNIXClientPool *
+gst_unix_client_pool_new (size_t slot_size, unsigned int n_slots)
+{
+  GstUNIXClientPool *pool;
+  long page;
+  unsigned int i;
+  void *memory;
+
+  if (slot_size == 0 || n_slots == 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  if (!(pool = calloc (1, sizeof (GstUNIXClientPool)))) {
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  page = sysconf (_SC_PAGESIZE);
+  if (page <= 0)
+    page = 4096;
+
+  pool->slot_size = slot_size;
+  pool->stride = (slot_size + page - 1) / page * page;
+  pool->n_slots = n_slots;
+
+  if (posix_memalign (&memory, page, pool->stride * n_slots) != 0) {
+    free (pool);
+    errno = ENOMEM;
+    return NULL;
+  }
+  pool->memory = memory;
+
+  if (!(pool->free_slots = malloc (n_slots * sizeof (void *)))) {
+    free (pool->memory);
+    free (pool);
+    errno = ENOMEM;
+    return NULL;
+  }
+  for (i = 0; i < n_slots; i++)
+    pool->free_slots[i] = pool->memory + (size_t) (n_slots - 1 - i) *
+        pool->stride;
+  pool->n_free = n_slots;
+
+  pthread_mutex_init (&pool->lock, NULL);
+
+  return pool;
+}
+
+/* all slots must have been released */
+void
+gst_unix_client_pool_free (GstUNIXClientPool * pool)
+{
+  pthread_mutex_destroy (&pool->lock);
+  free (pool->free_slots);
+  free (pool->memory);
+  free (pool);
+}
+
+size_t
+gst_unix_client_pool_get_slot_size (GstUNIXClientPool * pool)
+{
+  return pool->slot_size;
+}
+
+/* NULL with errno ENOBUFS when all slots are in use */
+void *
+gst_unix_client_pool_acquire (GstUNIXClientPool * pool)
+{
+  void *slot = NULL;
+
+  pthread_mutex_lock (&pool->lock);
+  if (pool->n_free > 0)
+    slot = pool->free_slots[--pool->n_free];
+  pthread_mutex_unlock (&pool->lock);
+
+  if (!slot)
+    errno = ENOBUFS;
+
+  return slot;
+}
+
+void
+gst_unix_client_pool_release (GstUNIXClientPool * pool, void *slot)
+{
+  pthread_mutex_lock (&pool->lock);
+  pool->free_slots[pool->n_free++] = slot;
+  pthread_mutex_unlock (&pool->lock);
+}
@@ -0,0 +1,141 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_CLIENT_H__
+#define __GST_UNIX_CLIENT_H__
+
+/* Standalone client side of the unixserversink protocols, for consumers
+ * that do not want to link GStreamer. Only depends on libc. Build against
+ * it with pkg-config gstreamer-unixclient-1.0 and include
+ * <gst/unix/gstunixclient.h>.
+ *
+ * Reading never allocates: payloads go straight from the socket into
+ * memory the caller provides, either its own or a slot of a
+ * #GstUNIXClientPool. With nonblocking set, every call returns -1 with
+ * errno EAGAIN instead of blocking and picks up where it stopped on the
+ * next call, so the fd from gst_unix_client_get_fd() can be watched with
+ * epoll:
+ *
+ *   GstUNIXClientOptions options = { 1, 1, NULL };
+ *   GstUNIXClient *client = gst_unix_client_connect (path, &options);
+ *
+ *   epoll_ctl (ep, EPOLL_CTL_ADD, gst_unix_client_get_fd (client), &ev);
+ *   ...
+ *   while ((ret = gst_unix_client_receive (client, &frame, slot, size)) > 0)
+ *     consume (&frame, slot);
+ *   if (ret == 0 || errno != EAGAIN)
+ *     ... stream ended or failed ...
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* wire format, kept in sync with gstunixprotocol.h */
+#define GST_UNIX_CLIENT_MAGIC           0x55545347
+#define GST_UNIX_CLIENT_VERSION         1
+#define GST_UNIX_CLIENT_HEADER_SIZE     64
+#define GST_UNIX_CLIENT_MAX_CAPS        4096
+
+#define GST_UNIX_CLIENT_FLAG_DISCONT    (1 << 0)
+#define GST_UNIX_CLIENT_FLAG_DELTA_UNIT (1 << 1)
+#define GST_UNIX_CLIENT_FLAG_HEADER     (1 << 2)
+
+/* pts, duration when the server did not know them */
+#define GST_UNIX_CLIENT_TIME_NONE       ((uint64_t) -1)
+
+typedef struct _GstUNIXClient GstUNIXClient;
+typedef struct _GstUNIXClientPool GstUNIXClientPool;
+
+/**
+ * GstUNIXClientOptions:
+ * @framed: speak the framed protocol, the server must use protocol=framed
+ * @nonblocking: never block, return -1 with errno EAGAIN instead
+ * @rendition: caps of the rendition to ask the server for, or NULL
+ */
+typedef struct {
+  int framed;
+  int nonblocking;
+  const char *rendition;
+} GstUNIXClientOptions;
+
+/**
+ * GstUNIXClientFrame:
+ * @seq: sequence number of the buffer
+ * @pts: presentation timestamp in nanoseconds
+ * @duration: duration in nanoseconds
+ * @send_time: CLOCK_MONOTONIC time in nanoseconds at which the server got
+ *   the buffer, 0 when the server does not stamp buffers
+ * @flags: GST_UNIX_CLIENT_FLAG_*
+ * @size: payload size in bytes
+ * @caps_changed: the server announced new caps before this buffer, see
+ *   gst_unix_client_get_caps()
+ */
+typedef struct {
+  uint64_t seq;
+  uint64_t pts;
+  uint64_t duration;
+  uint64_t send_time;
+  uint32_t flags;
+  uint32_t size;
+  int caps_changed;
+} GstUNIXClientFrame;
+
+/* all functions returning int return -1 and set errno on failure */
+GstUNIXClient     *gst_unix_client_connect    (const char *path,
+                                               const GstUNIXClientOptions *options);
+void               gst_unix_client_close      (GstUNIXClient *client);
+
+int                gst_unix_client_get_fd     (GstUNIXClient *client);
+const char        *gst_unix_client_get_caps   (GstUNIXClient *client);
+
+/* framed protocol: 1 with the next buffer in @frame, 0 at the end of the
+ * stream. The payload of the previous buffer is skipped if not read */
+int                gst_unix_client_next       (GstUNIXClient *client,
+                                               GstUNIXClientFrame *frame);
+/* payload of the current buffer, or the raw stream. 0 when the current
+ * buffer is complete or, for the raw protocol, at the end of the stream */
+ssize_t            gst_unix_client_read       (GstUNIXClient *client,
+                                               void *data, size_t size);
+/* both of the above: 1 with a complete buffer in @data, 0 at the end of the
+ * stream. Fails with EMSGSIZE, leaving the buffer pending and its size in
+ * @frame, when it does not fit */
+int                gst_unix_client_receive    (GstUNIXClient *client,
+                                               GstUNIXClientFrame *frame,
+                                               void *data, size_t size);
+
+/* fixed number of page aligned slots, safe to use from several threads */
+GstUNIXClientPool *gst_unix_client_pool_new   (size_t slot_size,
+                                               unsigned int n_slots);
+void               gst_unix_client_pool_free  (GstUNIXClientPool *pool);
+size_t             gst_unix_client_pool_get_slot_size (GstUNIXClientPool *pool);
+void              *gst_unix_client_pool_acquire (GstUNIXClientPool *pool);
+void               gst_unix_client_pool_release (GstUNIXClientPool *pool,
+                                               void *slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GST_UNIX_CLIENT_H__ */
@@ -32,6 +32,45 @@
  * # client:
  * gst-launch unixclientsrc path=/tmp/unix.sock ! fdsink fd=2
  * ]| everything you type in the server is shown on the client
+ * |[
+ * gst-launch unixclientsrc protocol=framed stripes=4 path=/tmp/unix.sock ! fakesink
+ * ]| receive every buffer split across 4 connections, each one read by its
+ * own thread, and reassemble it into a single buffer. Needs a unixserversink
+ * with protocol=framed. With a single connection, sender-thread asks the
+ * server to write to it from a thread of its own, like it does for every
+ * stripe, so large buffers can be spliced instead of copied.
+ *
+ * With in-process enabled, protocol=raw and the unixserversink serving the
+ * path living in the same process, the socket is bypassed and buffers are
+ * handed over by reference. This is off by default: the buffers are shared
+ * with the sink instead of copied, so a downstream writing into them must
+ * make them writable first, and such clients are not among the sink's socket
+ * clients.
+ * |[
+ * gst-launch unixclientsrc path=/tmp/unix.sock wait-for-server=true reconnect=true ! fdsink fd=2
+ * ]| start before the server exists and survive server restarts without
+ * going EOS.
+ * |[
+ * gst-launch unixclientsrc paths=/tmp/a.sock,/tmp/b.sock protocol=framed stall-timeout=50 ! fdsink fd=2
+ * ]| read from the first server that is up and keep a connection to the
+ * other one as hot standby, switching over when the active one hangs up or
+ * stays silent for 50 ms while the standby has data.
+ * |[
+ * gst-launch unixclientsrc protocol=framed rendition="audio/x-raw,format=S16LE,rate=16000,channels=1" ! fakesink
+ * ]| have the server convert the stream, the conversion is shared with all
+ * clients asking for the same rendition.
+ * |[
+ * gst-launch unixclientsrc path=/tmp/unix.sock capture-location=/tmp/stream.ucap ! fakesink
+ * ]| record every read from the socket with its arrival time, so
+ * gst-unix-replay can serve the exact same traffic later.
+ * |[
+ * gst-launch unixclientsrc path=/tmp/unix.sock prefetch=64 ! queue ! x264enc ! fakesink
+ * ]| keep draining the socket from a reader thread into a ring of 64
+ * buffers while the streaming thread is busy encoding.
+ *
+ * Socket buffers are sized like on unixserversink: latency-target sizes
+ * them for the measured bitrate, receive-buffer-size sets a fixed size.
+ * Linux caps them at net.core.rmem_max, stats report the granted size.
  * </refsect2>
  */
 
@@ -40,13 +79,50 @@
 #endif
 
 #include <gst/gst-i18n-plugin.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
 #include "gstunixclientsrc.h"
+#include "gstunixtrace.h"
 #include "gsttcp.h"
 
 GST_DEBUG_CATEGORY_STATIC (unixclientsrc_debug);
 #define GST_CAT_DEFAULT unixclientsrc_debug
 
 #define MAX_READ_SIZE                   4 * 1024
+#define STRIPE_QUEUE_MAX                4
+
+#define DEFAULT_PROTOCOL                GST_UNIX_PROTOCOL_RAW
+#define DEFAULT_STRIPES                 1
+#define DEFAULT_ALIGNMENT               0
+#define DEFAULT_HUGE_PAGES              GST_UNIX_HUGE_PAGES_NONE
+#define DEFAULT_CPU_AFFINITY            NULL
+#define DEFAULT_SCHED_POLICY            GST_UNIX_SCHED_POLICY_OTHER
+#define DEFAULT_SCHED_PRIORITY          1
+#define DEFAULT_LATENCY_META            FALSE
+#define DEFAULT_IN_PROCESS              FALSE
+#define DEFAULT_WAIT_FOR_SERVER         FALSE
+#define DEFAULT_RECONNECT               FALSE
+#define DEFAULT_MAX_BACKOFF             1000
+#define MIN_BACKOFF                     1       /* ms */
+#define DEFAULT_PATHS                   NULL
+#define DEFAULT_STALL_TIMEOUT           200
+#define DEFAULT_RENDITION               NULL
+#define DEFAULT_TRACE_TIMING            FALSE
+#define DEFAULT_CAPTURE_LOCATION        NULL
+#define DEFAULT_PREFETCH                0
+#define DEFAULT_PREFETCH_OVERFLOW       GST_UNIX_RING_OVERFLOW_BLOCK
+#define MAX_PREFETCH                    4096
+#define DEFAULT_LATENCY_TARGET          0
+#define DEFAULT_RECEIVE_BUFFER_SIZE     0
+#define DEFAULT_SENDER_THREAD           FALSE
+
+/* returned by wait_primary() when the primary went silent */
+#define GST_UNIX_CLIENT_SRC_FLOW_STALLED GST_FLOW_CUSTOM_ERROR
 
 
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
@@ -58,9 +134,60 @@ static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
 enum
 {
   PROP_0,
-  PROP_PATH
+  PROP_PATH,
+  PROP_PROTOCOL,
+  PROP_STRIPES,
+  PROP_ALIGNMENT,
+  PROP_HUGE_PAGES,
+  PROP_CPU_AFFINITY,
+  PROP_SCHED_POLICY,
+  PROP_SCHED_PRIORITY,
+  PROP_STATS,
+  PROP_LATENCY_META,
+  PROP_IN_PROCESS,
+  PROP_WAIT_FOR_SERVER,
+  PROP_RECONNECT,
+  PROP_MAX_BACKOFF,
+  PROP_PATHS,
+  PROP_STALL_TIMEOUT,
+  PROP_RENDITION,
+  PROP_TRACE_TIMING,
+  PROP_CAPTURE_LOCATION,
+  PROP_PREFETCH,
+  PROP_PREFETCH_OVERFLOW,
+  PROP_LATENCY_TARGET,
+  PROP_RECEIVE_BUFFER_SIZE,
+  PROP_SENDER_THREAD
+};
+
+struct _GstUNIXClientSrcStripe
+{
+  GstUNIXClientSrc *src;
+  guint index;
+  GSocket *socket;
+  GThread *thread;
+  GQueue queue;                 /* GstUNIXClientSrcChunk, protected by stripe_lock */
+  GstUNIXJitter jitter;         /* protected by the object lock */
 };
 
+/* one frame read by a stripe or the prefetch thread */
+typedef struct
+{
+  GstUNIXFrameHeader header;
+  GstBuffer *buffer;            /* NULL for empty payloads */
+  GstFlowReturn ret;
+  GError *error;
+  gboolean discont;             /* the prefetch thread dropped before */
+} GstUNIXClientSrcChunk;
+
+/* a pooled chunk buffer kept mapped while its memory is part of a striped
+ * buffer, so the memory goes back to the pool with it */
+typedef struct
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+} GstUNIXClientSrcParent;
+
 #define gst_unix_client_src_parent_class parent_class
 G_DEFINE_TYPE (GstUNIXClientSrc, gst_unix_client_src, GST_TYPE_PUSH_SRC);
 
@@ -73,9 +200,20 @@ static GstCaps *gst_unix_client_src_getcaps (GstBaseSrc * psrc,
 static GstFlowReturn gst_unix_client_src_create (GstPushSrc * psrc,
     GstBuffer ** outbuf);
 static gboolean gst_unix_client_src_stop (GstBaseSrc * bsrc);
+static gboolean gst_unix_client_src_post_message (GstElement * element,
+    GstMessage * message);
+static void gst_unix_client_src_configure_thread (GstUNIXClientSrc * src);
 static gboolean gst_unix_client_src_start (GstBaseSrc * bsrc);
 static gboolean gst_unix_client_src_unlock (GstBaseSrc * bsrc);
 static gboolean gst_unix_client_src_unlock_stop (GstBaseSrc * bsrc);
+static gboolean gst_unix_client_src_connect (GstUNIXClientSrc * src,
+    GError ** err);
+static void gst_unix_client_src_disconnect (GstUNIXClientSrc * src);
+static void gst_unix_client_src_close_standby (GstUNIXClientSrc * src);
+static GstFlowReturn gst_unix_client_src_pop (GstUNIXClientSrc * src,
+    GstUNIXFrameHeader * header, GstBuffer ** outbuf, GError ** err);
+static void gst_unix_client_src_set_paths (GstUNIXClientSrc * src,
+    const gchar * paths);
 
 static void gst_unix_client_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -99,10 +237,127 @@ gst_unix_client_src_class_init (GstUNIXClientSrcClass * klass)
   gobject_class->get_property = gst_unix_client_src_get_property;
   gobject_class->finalize = gst_unix_client_src_finalize;
 
+  gstelement_class->post_message = gst_unix_client_src_post_message;
+
   g_object_class_install_property (gobject_class, PROP_PATH,
       g_param_spec_string ("path", "path", "The UNIX socket path to open",
           UNIX_DEFAULT_PATH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
-
+  g_object_class_install_property (gobject_class, PROP_PROTOCOL,
+      g_param_spec_enum ("protocol", "Protocol",
+          "The wire protocol spoken with the server", GST_TYPE_UNIX_PROTOCOL,
+          DEFAULT_PROTOCOL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STRIPES,
+      g_param_spec_uint ("stripes", "Stripes",
+          "Number of parallel connections each buffer is split across "
+          "(needs protocol=framed)", 1, GST_UNIX_PROTOCOL_MAX_STRIPES,
+          DEFAULT_STRIPES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_ALIGNMENT,
+      g_param_spec_uint ("alignment", "Alignment",
+          "Alignment in bytes of received buffers, a power of two "
+          "(0 = system default)", 0, 4096, DEFAULT_ALIGNMENT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_HUGE_PAGES,
+      g_param_spec_enum ("huge-pages", "Huge pages",
+          "Back received buffers of at least 2 MiB with huge pages",
+          GST_TYPE_UNIX_HUGE_PAGES, DEFAULT_HUGE_PAGES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CPU_AFFINITY,
+      g_param_spec_string ("cpu-affinity", "CPU affinity",
+          "CPUs to pin the reading threads to, e.g. \"0-3,8\". Buffer memory "
+          "is then preferably allocated on their NUMA node",
+          DEFAULT_CPU_AFFINITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SCHED_POLICY,
+      g_param_spec_enum ("sched-policy", "Scheduling policy",
+          "Scheduling class of the reading threads", GST_TYPE_UNIX_SCHED_POLICY,
+          DEFAULT_SCHED_POLICY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SCHED_PRIORITY,
+      g_param_spec_int ("sched-priority", "Scheduling priority",
+          "Real-time priority for the fifo and rr scheduling policies", 1, 99,
+          DEFAULT_SCHED_PRIORITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Stats", "Statistics of the source",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LATENCY_META,
+      g_param_spec_boolean ("latency-meta", "Latency meta",
+          "Attach a GstUNIXLatencyMeta with the transport latency to buffers "
+          "stamped by a unixserversink with send-timestamps",
+          DEFAULT_LATENCY_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_IN_PROCESS,
+      g_param_spec_boolean ("in-process", "In process",
+          "Take buffers directly from a unixserversink of this process serving "
+          "the same path instead of going through the socket (raw protocol "
+          "only)",
+          DEFAULT_IN_PROCESS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_WAIT_FOR_SERVER,
+      g_param_spec_boolean ("wait-for-server", "Wait for server",
+          "Connect from the streaming thread and wait for the server to appear "
+          "instead of failing the state change",
+          DEFAULT_WAIT_FOR_SERVER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RECONNECT,
+      g_param_spec_boolean ("reconnect", "Reconnect",
+          "Reconnect when the server goes away instead of going EOS, the "
+          "first buffer after reconnecting is marked DISCONT",
+          DEFAULT_RECONNECT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_BACKOFF,
+      g_param_spec_uint ("max-backoff", "Maximum backoff",
+          "Upper bound in ms of the delay between connection attempts",
+          MIN_BACKOFF, G_MAXUINT, DEFAULT_MAX_BACKOFF,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PATHS,
+      g_param_spec_string ("paths", "Paths",
+          "Comma separated UNIX socket paths of redundant servers. Data is "
+          "read from one while a connection to the next is kept as hot "
+          "standby (overrides path, disables in-process)",
+          DEFAULT_PATHS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STALL_TIMEOUT,
+      g_param_spec_uint ("stall-timeout", "Stall timeout",
+          "Switch to the standby when the active server sent nothing for this "
+          "many ms while the standby did (0 = only on hang-up)",
+          0, G_MAXUINT, DEFAULT_STALL_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RENDITION,
+      g_param_spec_boxed ("rendition", "Rendition",
+          "Fixed caps the server should convert the stream to for us "
+          "(needs protocol=framed, NULL = as is)",
+          GST_TYPE_CAPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TRACE_TIMING,
+      g_param_spec_boolean ("trace-timing", "Trace timing",
+          "Break the time of every buffer down into waiting for data, reading "
+          "it and downstream processing, as histograms in stats",
+          DEFAULT_TRACE_TIMING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CAPTURE_LOCATION,
+      g_param_spec_string ("capture-location", "Capture location",
+          "File to record everything read from the socket to, with arrival "
+          "times, for gst-unix-replay (NULL = no capture)",
+          DEFAULT_CAPTURE_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PREFETCH,
+      g_param_spec_uint ("prefetch", "Prefetch",
+          "Buffers a reader thread reads ahead into a ring while downstream "
+          "is busy, rounded up to a power of two (0 = read in the streaming "
+          "thread)", 0, MAX_PREFETCH, DEFAULT_PREFETCH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_OVERFLOW,
+      g_param_spec_enum ("prefetch-overflow", "Prefetch overflow",
+          "What the reader thread does with data when the prefetch ring is "
+          "full", GST_TYPE_UNIX_RING_OVERFLOW, DEFAULT_PREFETCH_OVERFLOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LATENCY_TARGET,
+      g_param_spec_uint ("latency-target", "Latency target",
+          "Size the receive buffers to hold this many ms of the measured "
+          "bitrate (0 = kernel default)", 0, G_MAXUINT,
+          DEFAULT_LATENCY_TARGET, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RECEIVE_BUFFER_SIZE,
+      g_param_spec_int ("receive-buffer-size", "Receive buffer size",
+          "Receive buffer size of every connection in bytes, overrides "
+          "latency-target (0 = automatic)", 0, G_MAXINT,
+          DEFAULT_RECEIVE_BUFFER_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SENDER_THREAD,
+      g_param_spec_boolean ("sender-thread", "Sender thread",
+          "Ask the server for a thread of its own writing to the single "
+          "connection, which can splice large buffers (needs protocol=framed)",
+          DEFAULT_SENDER_THREAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&srctemplate));
@@ -130,6 +385,73 @@ gst_unix_client_src_init (GstUNIXClientSrc * this)
   this->path = g_strdup (UNIX_DEFAULT_PATH);
   this->socket = NULL;
   this->cancellable = g_cancellable_new ();
+  this->protocol = DEFAULT_PROTOCOL;
+  this->stripes = DEFAULT_STRIPES;
+  this->alignment = DEFAULT_ALIGNMENT;
+  this->huge_pages = DEFAULT_HUGE_PAGES;
+  this->allocator = NULL;
+  this->pool = NULL;
+  this->pool_size = 0;
+  this->thread_config.cpus = DEFAULT_CPU_AFFINITY;
+  this->thread_config.policy = DEFAULT_SCHED_POLICY;
+  this->thread_config.priority = DEFAULT_SCHED_PRIORITY;
+  this->task_pool =
+      gst_object_ref_sink (gst_unix_task_pool_new ((GFunc)
+          gst_unix_client_src_configure_thread, this));
+  gst_unix_jitter_reset (&this->jitter);
+  this->latency_meta = DEFAULT_LATENCY_META;
+  this->in_process = DEFAULT_IN_PROCESS;
+  this->wait_for_server = DEFAULT_WAIT_FOR_SERVER;
+  this->reconnect = DEFAULT_RECONNECT;
+  this->max_backoff = DEFAULT_MAX_BACKOFF;
+  this->connected = FALSE;
+  this->discont = FALSE;
+  this->disconnect_time = GST_CLOCK_TIME_NONE;
+  this->reconnects = 0;
+  this->reconnect_time = 0;
+  this->paths = NULL;
+  this->n_paths = 0;
+  this->active = 0;
+  this->stall_timeout = DEFAULT_STALL_TIMEOUT;
+  this->standby = NULL;
+  this->standby_retry = 0;
+  this->last_data = GST_CLOCK_TIME_NONE;
+  this->standby_data = GST_CLOCK_TIME_NONE;
+  this->switch_start = GST_CLOCK_TIME_NONE;
+  this->switches = 0;
+  this->switch_latency = 0;
+  this->rendition = DEFAULT_RENDITION;
+  this->trace_timing = DEFAULT_TRACE_TIMING;
+  this->create_start = GST_CLOCK_TIME_NONE;
+  this->create_end = GST_CLOCK_TIME_NONE;
+  this->wait_end = GST_CLOCK_TIME_NONE;
+  this->capture_location = DEFAULT_CAPTURE_LOCATION;
+  this->capture = NULL;
+  this->prefetch = DEFAULT_PREFETCH;
+  this->prefetch_overflow = DEFAULT_PREFETCH_OVERFLOW;
+  this->ring = NULL;
+  this->prefetch_thread = NULL;
+  this->prefetch_cancellable = NULL;
+  this->prefetch_failed = NULL;
+  this->latency_target = DEFAULT_LATENCY_TARGET;
+  this->receive_buffer_size = DEFAULT_RECEIVE_BUFFER_SIZE;
+  this->sender_thread = DEFAULT_SENDER_THREAD;
+  this->rcvbuf = 0;
+  this->rcvbuf_applied = 0;
+  this->rcvbuf_clamped = FALSE;
+  gst_unix_bitrate_reset (&this->bitrate);
+  gst_unix_histogram_reset (&this->wait_time);
+  gst_unix_histogram_reset (&this->read_time);
+  gst_unix_histogram_reset (&this->downstream_time);
+  this->standby_caps = NULL;
+  this->local = NULL;
+  gst_unix_histogram_reset (&this->latency);
+
+  this->stripe = NULL;
+  g_mutex_init (&this->stripe_lock);
+  g_cond_init (&this->stripe_cond);
+  this->stripe_cancellable = NULL;
+  this->stripe_flushing = FALSE;
 
   GST_OBJECT_FLAG_UNSET (this, GST_UNIX_CLIENT_SRC_OPEN);
 }
@@ -147,10 +469,47 @@ gst_unix_client_src_finalize (GObject * gobject)
   this->socket = NULL;
   g_free (this->path);
   this->path = NULL;
+  g_strfreev (this->paths);
+  this->paths = NULL;
+  gst_caps_replace (&this->rendition, NULL);
+  g_free (this->capture_location);
+  this->capture_location = NULL;
+  g_free (this->thread_config.cpus);
+  this->thread_config.cpus = NULL;
+  gst_object_unref (this->task_pool);
+  this->task_pool = NULL;
+
+  g_mutex_clear (&this->stripe_lock);
+  g_cond_clear (&this->stripe_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
 }
 
+/* run the streaming task on threads of our own. The affinity, real-time
+ * class and memory policy it gets would otherwise stay with a thread of the
+ * default pool and leak into whatever task reuses it */
+static gboolean
+gst_unix_client_src_post_message (GstElement * element, GstMessage * message)
+{
+  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (element);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STREAM_STATUS) {
+    GstStreamStatusType type;
+    GstElement *owner;
+    const GValue *val;
+
+    gst_message_parse_stream_status (message, &type, &owner);
+    val = gst_message_get_stream_status_object (message);
+    if (type == GST_STREAM_STATUS_TYPE_CREATE && owner == element &&
+        val && G_VALUE_HOLDS (val, GST_TYPE_TASK)) {
+      GST_DEBUG_OBJECT (src, "streaming task gets threads of its own");
+      gst_task_set_pool (GST_TASK (g_value_get_object (val)), src->task_pool);
+    }
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->post_message (element, message);
+}
+
 static GstCaps *
 gst_unix_client_src_getcaps (GstBaseSrc * bsrc, GstCaps * filter)
 {
@@ -159,281 +518,2032 @@ gst_unix_client_src_getcaps (GstBaseSrc * bsrc, GstCaps * filter)
 
   src = GST_UNIX_CLIENT_SRC (bsrc);
 
-  caps = (filter ? gst_caps_ref (filter) : gst_caps_new_any ());
+  GST_OBJECT_LOCK (src);
+  if (src->rendition) {
+    caps = filter ? gst_caps_intersect_full (filter, src->rendition,
+        GST_CAPS_INTERSECT_FIRST) : gst_caps_ref (src->rendition);
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  if (!caps)
+    caps = (filter ? gst_caps_ref (filter) : gst_caps_new_any ());
 
   GST_DEBUG_OBJECT (src, "returning caps %" GST_PTR_FORMAT, caps);
   g_assert (GST_IS_CAPS (caps));
   return caps;
 }
 
-static GstFlowReturn
-gst_unix_client_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
+static GstBufferPool *
+gst_unix_client_src_new_pool (GstUNIXClientSrc * src, gsize size)
 {
-  GstUNIXClientSrc *src;
-  GstFlowReturn ret = GST_FLOW_OK;
-  gssize rret;
-  GError *err = NULL;
-  GstMapInfo map;
-  gssize avail, read;
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+  gst_buffer_pool_config_set_allocator (config, src->allocator, &src->params);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (src, "failed to set up buffer pool of size %"
+        G_GSIZE_FORMAT, size);
+    gst_object_unref (pool);
+    return NULL;
+  }
 
-  src = GST_UNIX_CLIENT_SRC (psrc);
+  GST_DEBUG_OBJECT (src, "new buffer pool with buffers of %" G_GSIZE_FORMAT
+      " bytes", size);
 
-  if (!GST_OBJECT_FLAG_IS_SET (src, GST_UNIX_CLIENT_SRC_OPEN))
-    goto wrong_state;
+  return pool;
+}
 
-  GST_LOG_OBJECT (src, "asked for a buffer");
+/* get a buffer of @size bytes. Buffers come from a pool so their memory is
+ * recycled; the pool is replaced by a larger one when frames outgrow it */
+static GstBuffer *
+gst_unix_client_src_alloc_buffer (GstUNIXClientSrc * src, gsize size)
+{
+  GstBufferPool *pool = NULL;
+  GstBuffer *buf = NULL;
+
+  GST_OBJECT_LOCK (src);
+  if (!src->pool || src->pool_size < size) {
+    if (src->pool) {
+      gst_buffer_pool_set_active (src->pool, FALSE);
+      gst_object_unref (src->pool);
+    }
+    src->pool = gst_unix_client_src_new_pool (src, size);
+    src->pool_size = src->pool ? size : 0;
+  }
+  if (src->pool)
+    pool = gst_object_ref (src->pool);
+  GST_OBJECT_UNLOCK (src);
 
-  /* read the buffer header */
-  avail = g_socket_get_available_bytes (src->socket);
-  if (avail < 0) {
-    goto get_available_error;
-  } else if (avail == 0) {
-    GIOCondition condition;
+  if (pool) {
+    gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+    gst_object_unref (pool);
+  }
 
-    if (!g_socket_condition_wait (src->socket,
-            G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP, src->cancellable, &err))
-      goto select_error;
+  /* pool replaced from another thread or not available */
+  if (!buf)
+    return gst_buffer_new_allocate (src->allocator, size, &src->params);
 
-    condition =
-        g_socket_condition_check (src->socket,
-        G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP);
+  if (gst_buffer_get_size (buf) != size)
+    gst_buffer_resize (buf, 0, size);
 
-    if ((condition & G_IO_ERR)) {
-      GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
-          ("Socket in error state"));
-      *outbuf = NULL;
-      ret = GST_FLOW_ERROR;
-      goto done;
-    } else if ((condition & G_IO_HUP)) {
-      GST_DEBUG_OBJECT (src, "Connection closed");
-      *outbuf = NULL;
-      ret = GST_FLOW_EOS;
-      goto done;
-    }
-    avail = g_socket_get_available_bytes (src->socket);
-    if (avail < 0)
-      goto get_available_error;
-  }
+  return buf;
+}
 
-  if (avail > 0) {
-    read = MIN (avail, MAX_READ_SIZE);
-    *outbuf = gst_buffer_new_and_alloc (read);
-    gst_buffer_map (*outbuf, &map, GST_MAP_READWRITE);
-    rret =
-        g_socket_receive (src->socket, (gchar *) map.data, read,
-        src->cancellable, &err);
-  } else {
-    /* Connection closed */
-    *outbuf = NULL;
-    read = 0;
-    rret = 0;
-  }
+/* the path to connect to, switches between the servers given in paths */
+static const gchar *
+gst_unix_client_src_active_path (GstUNIXClientSrc * src)
+{
+  return src->paths ? src->paths[src->active] : src->path;
+}
 
-  if (rret == 0) {
-    GST_DEBUG_OBJECT (src, "Connection closed");
-    ret = GST_FLOW_EOS;
-    if (*outbuf) {
-      gst_buffer_unmap (*outbuf, &map);
-      gst_buffer_unref (*outbuf);
-    }
-    *outbuf = NULL;
-  } else if (rret < 0) {
-    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-      ret = GST_FLOW_FLUSHING;
-      GST_DEBUG_OBJECT (src, "Cancelled reading from socket");
-    } else {
-      ret = GST_FLOW_ERROR;
-      GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
-          ("Failed to read from socket: %s", err->message));
-    }
-    gst_buffer_unmap (*outbuf, &map);
-    gst_buffer_unref (*outbuf);
-    *outbuf = NULL;
-  } else {
-    ret = GST_FLOW_OK;
-    gst_buffer_unmap (*outbuf, &map);
-    gst_buffer_resize (*outbuf, 0, rret);
-
-    GST_LOG_OBJECT (src,
-        "Returning buffer from _get of size %" G_GSIZE_FORMAT ", ts %"
-        GST_TIME_FORMAT ", dur %" GST_TIME_FORMAT
-        ", offset %" G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT,
-        gst_buffer_get_size (*outbuf),
-        GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (*outbuf)),
-        GST_TIME_ARGS (GST_BUFFER_DURATION (*outbuf)),
-        GST_BUFFER_OFFSET (*outbuf), GST_BUFFER_OFFSET_END (*outbuf));
-  }
-  g_clear_error (&err);
+/* set the receive buffer of @socket to @size, remembering what the kernel
+ * granted */
+static void
+gst_unix_client_src_apply_rcvbuf (GstUNIXClientSrc * src, GSocket * socket,
+    gint size)
+{
+  gint applied;
+  gboolean warn = FALSE;
+
+  applied = gst_unix_socket_set_buffer_size (socket, FALSE, size);
+  if (applied < 0)
+    return;
+
+  GST_OBJECT_LOCK (src);
+  src->rcvbuf_applied = applied;
+  if (gst_unix_sockbuf_clamped (size, applied) && !src->rcvbuf_clamped)
+    warn = src->rcvbuf_clamped = TRUE;
+  GST_OBJECT_UNLOCK (src);
+
+  if (warn)
+    GST_ELEMENT_WARNING (src, RESOURCE, SETTINGS, (NULL),
+        ("Receive buffer of %d bytes wanted, got %d; raise "
+            "net.core.rmem_max", size, applied));
+}
 
-done:
-  return ret;
+/* size the receive buffer of a new connection carrying 1/@share of the
+ * stream */
+static void
+gst_unix_client_src_size_socket (GstUNIXClientSrc * src, GSocket * socket,
+    guint share)
+{
+  gint size = 0;
 
-select_error:
-  {
-    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-      GST_DEBUG_OBJECT (src, "Cancelled");
-      ret = GST_FLOW_FLUSHING;
-    } else {
-      GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
-          ("Select failed: %s", err->message));
-      ret = GST_FLOW_ERROR;
-    }
-    g_clear_error (&err);
-    return ret;
-  }
-get_available_error:
-  {
-    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
-        ("Failed to get available bytes from socket"));
-    return GST_FLOW_ERROR;
+  GST_OBJECT_LOCK (src);
+  if (src->receive_buffer_size > 0)
+    size = src->receive_buffer_size;
+  else if (src->rcvbuf > 0)
+    size = MAX (src->rcvbuf / share, GST_UNIX_SOCKBUF_MIN);
+  GST_OBJECT_UNLOCK (src);
+
+  if (size > 0)
+    gst_unix_client_src_apply_rcvbuf (src, socket, size);
+}
+
+/* size the receive buffers of the current connection for the measured
+ * bitrate */
+static void
+gst_unix_client_src_resize (GstUNIXClientSrc * src)
+{
+  guint64 rate;
+  gint size;
+  guint i;
+
+  GST_OBJECT_LOCK (src);
+  rate = src->bitrate.rate;
+  size = gst_unix_sockbuf_size_for (rate, src->latency_target * GST_MSECOND);
+  if (!gst_unix_sockbuf_differs (src->rcvbuf, size)) {
+    GST_OBJECT_UNLOCK (src);
+    return;
   }
-wrong_state:
-  {
-    GST_DEBUG_OBJECT (src, "connection to closed, cannot read data");
-    return GST_FLOW_FLUSHING;
+  src->rcvbuf = size;
+  GST_OBJECT_UNLOCK (src);
+
+  GST_DEBUG_OBJECT (src, "bitrate %" G_GUINT64_FORMAT " bytes/s, receive "
+      "buffers now %d bytes", rate, size);
+
+  if (src->stripe) {
+    for (i = 0; i < src->stripes; i++)
+      gst_unix_client_src_apply_rcvbuf (src, src->stripe[i].socket,
+          MAX (size / src->stripes, GST_UNIX_SOCKBUF_MIN));
+  } else if (src->socket) {
+    gst_unix_client_src_apply_rcvbuf (src, src->socket, size);
   }
 }
 
-static void
-gst_unix_client_src_set_property (GObject * object, guint prop_id,
-    const GValue * value, GParamSpec * pspec)
+/* data is there, everything from now on is reading it */
+static inline void
+gst_unix_client_src_wait_done (GstUNIXClientSrc * src)
 {
-  GstUNIXClientSrc *unixclientsrc = GST_UNIX_CLIENT_SRC (object);
+  GST_UNIX_TRACE1 (client_wait_end, src);
+  if (G_UNLIKELY (src->trace_timing))
+    src->wait_end = gst_unix_latency_now ();
+}
 
-  switch (prop_id) {
-    case PROP_PATH:
-      if (!g_value_get_string (value)) {
-        g_warning ("path property cannot be NULL");
-        break;
-      }
-      g_free (unixclientsrc->path);
-      unixclientsrc->path = g_strdup (g_value_get_string (value));
-      break;
+/* parse the payload of a CAPS message */
+static GstCaps *
+gst_unix_client_src_parse_caps (GstBuffer * buffer)
+{
+  GstMapInfo map;
+  GstCaps *caps = NULL;
 
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
-  }
+  if (!buffer)
+    return NULL;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (map.size > 0 && map.data[map.size - 1] == '\0')
+    caps = gst_caps_from_string ((const gchar *) map.data);
+  gst_buffer_unmap (buffer, &map);
+
+  return caps;
 }
 
+/* ask for our rendition in @hello */
 static void
-gst_unix_client_src_get_property (GObject * object, guint prop_id,
-    GValue * value, GParamSpec * pspec)
+gst_unix_client_src_add_rendition (GstUNIXClientSrc * src,
+    GstStructure * hello)
 {
-  GstUNIXClientSrc *unixclientsrc = GST_UNIX_CLIENT_SRC (object);
+  gchar *str;
 
-  switch (prop_id) {
-    case PROP_PATH:
-      g_value_set_string (value, unixclientsrc->path);
-      break;
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+  GST_OBJECT_LOCK (src);
+  if (src->rendition) {
+    str = gst_caps_to_string (src->rendition);
+    gst_structure_set (hello, "rendition", G_TYPE_STRING, str, NULL);
+    g_free (str);
   }
+  GST_OBJECT_UNLOCK (src);
 }
 
-/* create a socket for connecting to remote server */
-static gboolean
-gst_unix_client_src_start (GstBaseSrc * bsrc)
+/* record @size bytes read from the socket. The capture is only used by the
+ * thread reading the socket, which stops it when the file cannot be
+ * written; the stream itself goes on */
+static void
+gst_unix_client_src_capture (GstUNIXClientSrc * src, gconstpointer data,
+    gsize size)
 {
-  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (bsrc);
   GError *err = NULL;
-  GSocketAddress *usaddr;
 
-  usaddr = g_unix_socket_address_new (src->path);
+  if (gst_unix_capture_write (src->capture, data, size, &err))
+    return;
 
-  /* create receiving client socket */
-  GST_DEBUG_OBJECT (src, "opening receiving client socket at %s",
-      src->path);
-
-  src->socket =
-      g_socket_new (G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM,
-      G_SOCKET_PROTOCOL_DEFAULT, &err);
-  if (!src->socket)
-    goto no_socket;
+  GST_ELEMENT_WARNING (src, RESOURCE, WRITE, (NULL),
+      ("Stopped capturing: %s", err->message));
+  g_clear_error (&err);
+  gst_unix_capture_free (src->capture);
+  src->capture = NULL;
+}
 
-  GST_DEBUG_OBJECT (src, "opened receiving client socket at %s", src->path);
-  GST_OBJECT_FLAG_SET (src, GST_UNIX_CLIENT_SRC_OPEN);
+/* read one framed message from @socket */
+static GstFlowReturn
+gst_unix_client_src_read_frame (GstUNIXClientSrc * src, GSocket * socket,
+    GCancellable * cancellable, GstUNIXFrameHeader * header,
+    GstBuffer ** buffer, GError ** err)
+{
+  GstFlowReturn ret;
+  GstMapInfo map;
 
-  /* connect to server */
-  if (!g_socket_connect (src->socket, usaddr, src->cancellable, &err))
-    goto connect_failed;
-  GST_DEBUG_OBJECT (src, "connected to socket at %s", src->path);
+  *buffer = NULL;
 
-  g_object_unref (usaddr);
+  ret = gst_unix_socket_receive_all (socket, header,
+      sizeof (GstUNIXFrameHeader), cancellable, err);
+  if (ret != GST_FLOW_OK)
+    return ret;
 
-  return TRUE;
+  if (socket == src->socket) {
+    if (!src->ring)
+      gst_unix_client_src_wait_done (src);
+    if (src->capture)
+      gst_unix_client_src_capture (src, header, sizeof (GstUNIXFrameHeader));
+  }
 
-no_socket:
-  {
-    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
-        ("Failed to create socket: %s", err->message));
-    g_clear_error (&err);
-    g_object_unref (usaddr);
-    return FALSE;
+  if (!gst_unix_frame_header_is_valid (header) ||
+      (header->type != GST_UNIX_MESSAGE_BUFFER &&
+          (header->type != GST_UNIX_MESSAGE_CAPS ||
+              header->size > GST_UNIX_PROTOCOL_MAX_HELLO))) {
+    g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "Invalid frame header");
+    return GST_FLOW_ERROR;
   }
-connect_failed:
-  {
-    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-      GST_DEBUG_OBJECT (src, "Cancelled connecting");
-    } else {
-      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
-          ("Failed to connect to socket at '%s': %s", src->path, err->message));
+
+  if (header->size == 0)
+    return GST_FLOW_OK;
+
+  *buffer = gst_unix_client_src_alloc_buffer (src, header->size);
+  gst_buffer_map (*buffer, &map, GST_MAP_WRITE);
+  ret = gst_unix_socket_receive_all (socket, map.data, header->size,
+      cancellable, err);
+  if (ret == GST_FLOW_OK && src->capture && socket == src->socket)
+    gst_unix_client_src_capture (src, map.data, header->size);
+  gst_buffer_unmap (*buffer, &map);
+
+  if (ret != GST_FLOW_OK) {
+    /* a connection closed in the middle of a frame is an error */
+    if (ret == GST_FLOW_EOS) {
+      g_set_error (err, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Connection closed in the middle of a frame");
+      ret = GST_FLOW_ERROR;
     }
-    g_clear_error (&err);
-    g_object_unref (usaddr);
-    gst_unix_client_src_stop (GST_BASE_SRC (src));
-    return FALSE;
+    gst_buffer_unref (*buffer);
+    *buffer = NULL;
+  }
+
+  return ret;
+}
+
+static void
+gst_unix_client_src_apply_header (GstBuffer * buf,
+    const GstUNIXFrameHeader * header)
+{
+  GST_BUFFER_PTS (buf) = header->pts;
+  GST_BUFFER_DURATION (buf) = header->duration;
+
+  if (header->flags & GST_UNIX_FRAME_FLAG_DISCONT)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+  if (header->flags & GST_UNIX_FRAME_FLAG_DELTA_UNIT)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  if (header->flags & GST_UNIX_FRAME_FLAG_HEADER)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_HEADER);
+}
+
+/* account the transport latency of a buffer the server stamped */
+static void
+gst_unix_client_src_measure_latency (GstUNIXClientSrc * src, GstBuffer * buf,
+    const GstUNIXFrameHeader * header)
+{
+  GstClockTime now, latency;
+
+  if (header->send_time == 0)
+    return;
+
+  now = gst_unix_latency_now ();
+  latency = now > header->send_time ? now - header->send_time : 0;
+
+  GST_OBJECT_LOCK (src);
+  gst_unix_histogram_record (&src->latency, latency);
+  GST_OBJECT_UNLOCK (src);
+
+  if (src->latency_meta)
+    gst_buffer_add_unix_latency_meta (buf, header->send_time, latency);
+}
+
+/* a failed read is fatal, unless we are going to reconnect or switch to
+ * the standby */
+#define GST_UNIX_CLIENT_SRC_READ_ERROR(src, args) G_STMT_START {      \
+  if ((src)->reconnect || (src)->standby) {                           \
+    gchar *__dbg = g_strdup_printf args;                              \
+    GST_WARNING_OBJECT (src, "%s, reconnecting", __dbg);              \
+    g_free (__dbg);                                                   \
+  } else {                                                            \
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), args);            \
+  }                                                                   \
+} G_STMT_END
+
+/* post an error for a failed read, @err is cleared */
+static GstFlowReturn
+gst_unix_client_src_read_failed (GstUNIXClientSrc * src, GstFlowReturn ret,
+    GError ** err)
+{
+  if (ret == GST_FLOW_EOS) {
+    GST_DEBUG_OBJECT (src, "Connection closed");
+  } else if (ret == GST_FLOW_FLUSHING) {
+    GST_DEBUG_OBJECT (src, "Cancelled reading from socket");
+  } else {
+    GST_UNIX_CLIENT_SRC_READ_ERROR (src, ("Failed to read from socket: %s",
+            (err && *err) ? (*err)->message : "unknown error"));
   }
+  g_clear_error (err);
+
+  return ret;
 }
 
-/* close the socket and associated resources
- * unset OPEN flag
- * used both to recover from errors and go to NULL state */
-static gboolean
-gst_unix_client_src_stop (GstBaseSrc * bsrc)
+static GstFlowReturn
+gst_unix_client_src_create_framed (GstUNIXClientSrc * src, GstBuffer ** outbuf)
 {
-  GstUNIXClientSrc *src;
+  GstUNIXFrameHeader header;
+  GstFlowReturn ret;
   GError *err = NULL;
+  GstCaps *caps;
+
+  while (TRUE) {
+    if (src->ring)
+      ret = gst_unix_client_src_pop (src, &header, outbuf, &err);
+    else
+      ret = gst_unix_client_src_read_frame (src, src->socket,
+          src->cancellable, &header, outbuf, &err);
+    if (ret != GST_FLOW_OK)
+      return gst_unix_client_src_read_failed (src, ret, &err);
+    if (header.type == GST_UNIX_MESSAGE_BUFFER)
+      break;
 
-  src = GST_UNIX_CLIENT_SRC (bsrc);
-
-  if (src->socket) {
-    GST_DEBUG_OBJECT (src, "closing socket");
+    /* the server converts for us and tells us the format */
+    caps = gst_unix_client_src_parse_caps (*outbuf);
+    if (*outbuf)
+      gst_buffer_unref (*outbuf);
+    *outbuf = NULL;
+    if (!caps)
+      goto invalid_caps;
 
-    if (!g_socket_close (src->socket, &err)) {
-      GST_ERROR_OBJECT (src, "Failed to close socket: %s", err->message);
-      g_clear_error (&err);
-    }
-    g_object_unref (src->socket);
-    src->socket = NULL;
+    GST_DEBUG_OBJECT (src, "server sends %" GST_PTR_FORMAT, caps);
+    gst_base_src_set_caps (GST_BASE_SRC (src), caps);
+    gst_caps_unref (caps);
   }
 
-  GST_OBJECT_FLAG_UNSET (src, GST_UNIX_CLIENT_SRC_OPEN);
+  if (!*outbuf)
+    *outbuf = gst_buffer_new ();
+  gst_unix_client_src_apply_header (*outbuf, &header);
+  gst_unix_client_src_measure_latency (src, *outbuf, &header);
 
-  return TRUE;
+  GST_LOG_OBJECT (src, "Returning framed buffer %" G_GUINT64_FORMAT
+      " of size %u", header.seq, header.size);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+invalid_caps:
+  {
+    GST_UNIX_CLIENT_SRC_READ_ERROR (src, ("Server sent invalid caps"));
+    return GST_FLOW_ERROR;
+  }
 }
 
-/* will be called only between calls to start() and stop() */
-static gboolean
-gst_unix_client_src_unlock (GstBaseSrc * bsrc)
+/* pin the calling thread as configured */
+static void
+gst_unix_client_src_configure_thread (GstUNIXClientSrc * src)
 {
-  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (bsrc);
+  GstUNIXThreadConfig config;
 
-  GST_DEBUG_OBJECT (src, "set to flushing");
-  g_cancellable_cancel (src->cancellable);
+  GST_OBJECT_LOCK (src);
+  config = src->thread_config;
+  config.cpus = g_strdup (config.cpus);
+  GST_OBJECT_UNLOCK (src);
 
-  return TRUE;
+  gst_unix_thread_config_apply (&config, GST_OBJECT_CAST (src));
+  g_free (config.cpus);
 }
 
-/* will be called only between calls to start() and stop() */
-static gboolean
-gst_unix_client_src_unlock_stop (GstBaseSrc * bsrc)
+static gpointer
+gst_unix_client_src_stripe_thread (GstUNIXClientSrcStripe * stripe)
 {
-  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (bsrc);
+  GstUNIXClientSrc *src = stripe->src;
+  GstUNIXClientSrcChunk *chunk;
+  GstFlowReturn ret;
+
+  gst_unix_client_src_configure_thread (src);
+
+  do {
+    chunk = g_slice_new0 (GstUNIXClientSrcChunk);
+    ret = chunk->ret =
+        gst_unix_client_src_read_frame (src, stripe->socket,
+        src->stripe_cancellable, &chunk->header, &chunk->buffer,
+        &chunk->error);
+
+    GST_OBJECT_LOCK (src);
+    gst_unix_jitter_update (&stripe->jitter);
+    GST_OBJECT_UNLOCK (src);
+
+    g_mutex_lock (&src->stripe_lock);
+    while (g_queue_get_length (&stripe->queue) >= STRIPE_QUEUE_MAX &&
+        !g_cancellable_is_cancelled (src->stripe_cancellable))
+      g_cond_wait (&src->stripe_cond, &src->stripe_lock);
+    g_queue_push_tail (&stripe->queue, chunk);
+    g_cond_broadcast (&src->stripe_cond);
+    g_mutex_unlock (&src->stripe_lock);
+  } while (ret == GST_FLOW_OK);
+
+  return NULL;
+}
 
-  GST_DEBUG_OBJECT (src, "unset flushing");
-  g_cancellable_reset (src->cancellable);
+static void
+gst_unix_client_src_chunk_free (GstUNIXClientSrcChunk * chunk)
+{
+  if (chunk->buffer)
+    gst_buffer_unref (chunk->buffer);
+  g_clear_error (&chunk->error);
+  g_slice_free (GstUNIXClientSrcChunk, chunk);
+}
+
+static void
+gst_unix_client_src_parent_free (GstUNIXClientSrcParent * parent)
+{
+  gst_buffer_unmap (parent->buffer, &parent->map);
+  gst_buffer_unref (parent->buffer);
+  g_slice_free (GstUNIXClientSrcParent, parent);
+}
+
+/* wrap the memory of @buffer, taking ownership of it. gst_buffer_append()
+ * would take the memory out of the pooled buffer and the pool would drop it
+ * instead of recycling it; this keeps @buffer alive as the parent until the
+ * wrapping memory is freed */
+static GstMemory *
+gst_unix_client_src_wrap_chunk (GstBuffer * buffer)
+{
+  GstUNIXClientSrcParent *parent;
+
+  parent = g_slice_new (GstUNIXClientSrcParent);
+  parent->buffer = buffer;
+  if (!gst_buffer_map (buffer, &parent->map, GST_MAP_READWRITE)) {
+    gst_buffer_unref (buffer);
+    g_slice_free (GstUNIXClientSrcParent, parent);
+    return NULL;
+  }
+
+  return gst_memory_new_wrapped (0, parent->map.data, parent->map.size, 0,
+      parent->map.size, parent, (GDestroyNotify)
+      gst_unix_client_src_parent_free);
+}
+
+/* called with stripe_lock. A buffer can be assembled once every stripe has
+ * a chunk queued, or as soon as one of them reports a failure */
+static gboolean
+gst_unix_client_src_stripes_ready (GstUNIXClientSrc * src)
+{
+  gboolean ready = TRUE;
+  guint i;
+
+  for (i = 0; i < src->stripes; i++) {
+    GstUNIXClientSrcChunk *chunk = g_queue_peek_head (&src->stripe[i].queue);
+
+    if (!chunk)
+      ready = FALSE;
+    else if (chunk->ret != GST_FLOW_OK)
+      return TRUE;
+  }
+  return ready;
+}
+
+static GstFlowReturn
+gst_unix_client_src_create_striped (GstUNIXClientSrc * src,
+    GstBuffer ** outbuf)
+{
+  GstUNIXClientSrcChunk *chunks[GST_UNIX_PROTOCOL_MAX_STRIPES] = { NULL, };
+  GstFlowReturn ret = GST_FLOW_OK;
+  GError *err = NULL;
+  guint i;
+
+  g_mutex_lock (&src->stripe_lock);
+  while (!src->stripe_flushing && !gst_unix_client_src_stripes_ready (src))
+    g_cond_wait (&src->stripe_cond, &src->stripe_lock);
+  gst_unix_client_src_wait_done (src);
+  if (src->stripe_flushing) {
+    g_mutex_unlock (&src->stripe_lock);
+    GST_DEBUG_OBJECT (src, "Cancelled reading from stripes");
+    return GST_FLOW_FLUSHING;
+  }
+  for (i = 0; i < src->stripes; i++) {
+    GstUNIXClientSrcChunk *chunk = g_queue_peek_head (&src->stripe[i].queue);
+
+    if (chunk && chunk->ret != GST_FLOW_OK) {
+      /* leave the failed chunk queued, every later create fails the same */
+      ret = chunk->ret;
+      err = chunk->error ? g_error_copy (chunk->error) : NULL;
+      break;
+    }
+  }
+  if (ret == GST_FLOW_OK) {
+    for (i = 0; i < src->stripes; i++)
+      chunks[i] = g_queue_pop_head (&src->stripe[i].queue);
+  }
+  g_cond_broadcast (&src->stripe_cond);
+  g_mutex_unlock (&src->stripe_lock);
+
+  if (ret != GST_FLOW_OK)
+    return gst_unix_client_src_read_failed (src, ret, &err);
+
+  *outbuf = gst_buffer_new ();
+  for (i = 0; i < src->stripes; i++) {
+    if (chunks[i]->header.seq != chunks[0]->header.seq)
+      goto out_of_sync;
+    if (chunks[i]->buffer) {
+      GstMemory *mem = gst_unix_client_src_wrap_chunk (chunks[i]->buffer);
+
+      chunks[i]->buffer = NULL;
+      if (!mem)
+        goto map_failed;
+      gst_buffer_append_memory (*outbuf, mem);
+    }
+  }
+  gst_unix_client_src_apply_header (*outbuf, &chunks[0]->header);
+  gst_unix_client_src_measure_latency (src, *outbuf, &chunks[0]->header);
+
+  GST_LOG_OBJECT (src, "Returning striped buffer %" G_GUINT64_FORMAT
+      " of size %" G_GSIZE_FORMAT, chunks[0]->header.seq,
+      gst_buffer_get_size (*outbuf));
+
+done:
+  for (i = 0; i < src->stripes; i++)
+    gst_unix_client_src_chunk_free (chunks[i]);
+
+  return ret;
+
+  /* ERRORS */
+out_of_sync:
+  {
+    GST_UNIX_CLIENT_SRC_READ_ERROR (src, ("Stripes out of sync: %" G_GUINT64_FORMAT " != %" G_GUINT64_FORMAT,
+            chunks[i]->header.seq, chunks[0]->header.seq));
+    gst_buffer_unref (*outbuf);
+    *outbuf = NULL;
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
+map_failed:
+  {
+    GST_UNIX_CLIENT_SRC_READ_ERROR (src, ("Failed to map stripe buffer"));
+    gst_buffer_unref (*outbuf);
+    *outbuf = NULL;
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
+}
+
+/* read what is available on the socket, at most MAX_READ_SIZE bytes.
+ * Errors are returned, not posted */
+static GstFlowReturn
+gst_unix_client_src_read_raw (GstUNIXClientSrc * src,
+    GCancellable * cancellable, GstBuffer ** outbuf, GError ** err)
+{
+  GstMapInfo map;
+  gssize avail, read, rret;
+
+  *outbuf = NULL;
+
+  avail = g_socket_get_available_bytes (src->socket);
+  if (avail < 0) {
+    goto get_available_error;
+  } else if (avail == 0) {
+    GIOCondition condition;
+
+    if (!g_socket_condition_wait (src->socket,
+            G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP, cancellable, err))
+      goto select_error;
+
+    condition =
+        g_socket_condition_check (src->socket,
+        G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP);
+
+    if ((condition & G_IO_ERR)) {
+      g_set_error (err, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Socket in error state");
+      return GST_FLOW_ERROR;
+    } else if ((condition & G_IO_HUP)) {
+      return GST_FLOW_EOS;
+    }
+    avail = g_socket_get_available_bytes (src->socket);
+    if (avail < 0)
+      goto get_available_error;
+  }
+  if (!src->ring)
+    gst_unix_client_src_wait_done (src);
+
+  /* Connection closed */
+  if (avail == 0)
+    return GST_FLOW_EOS;
+
+  read = MIN (avail, MAX_READ_SIZE);
+  *outbuf = gst_unix_client_src_alloc_buffer (src, MAX_READ_SIZE);
+  gst_buffer_map (*outbuf, &map, GST_MAP_READWRITE);
+  rret = g_socket_receive (src->socket, (gchar *) map.data, read,
+      cancellable, err);
+  if (rret > 0 && src->capture)
+    gst_unix_client_src_capture (src, map.data, rret);
+  gst_buffer_unmap (*outbuf, &map);
+
+  if (rret <= 0) {
+    gst_buffer_unref (*outbuf);
+    *outbuf = NULL;
+    if (rret == 0)
+      return GST_FLOW_EOS;
+    if (g_error_matches (*err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      return GST_FLOW_FLUSHING;
+    return GST_FLOW_ERROR;
+  }
+  gst_buffer_resize (*outbuf, 0, rret);
+
+  GST_LOG_OBJECT (src,
+      "Returning buffer from _get of size %" G_GSIZE_FORMAT ", ts %"
+      GST_TIME_FORMAT ", dur %" GST_TIME_FORMAT
+      ", offset %" G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT,
+      gst_buffer_get_size (*outbuf),
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (*outbuf)),
+      GST_TIME_ARGS (GST_BUFFER_DURATION (*outbuf)),
+      GST_BUFFER_OFFSET (*outbuf), GST_BUFFER_OFFSET_END (*outbuf));
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+select_error:
+  {
+    if (g_error_matches (*err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      return GST_FLOW_FLUSHING;
+    return GST_FLOW_ERROR;
+  }
+get_available_error:
+  {
+    g_set_error (err, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Failed to get available bytes from socket");
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* keeps draining the socket into the ring while the streaming thread is
+ * busy downstream. Stops after the first failure, which is queued as well */
+static gpointer
+gst_unix_client_src_prefetch_thread (GstUNIXClientSrc * src)
+{
+  GstUNIXClientSrcChunk *chunk;
+  GstUNIXRingOverflow overflow;
+  gboolean discont = FALSE, drop;
+  GstFlowReturn ret;
+
+  gst_unix_client_src_configure_thread (src);
+
+  GST_OBJECT_LOCK (src);
+  overflow = src->prefetch_overflow;
+  GST_OBJECT_UNLOCK (src);
+
+  do {
+    chunk = g_slice_new0 (GstUNIXClientSrcChunk);
+    if (src->protocol == GST_UNIX_PROTOCOL_FRAMED) {
+      ret = gst_unix_client_src_read_frame (src, src->socket,
+          src->prefetch_cancellable, &chunk->header, &chunk->buffer,
+          &chunk->error);
+    } else {
+      ret = gst_unix_client_src_read_raw (src, src->prefetch_cancellable,
+          &chunk->buffer, &chunk->error);
+    }
+    chunk->ret = ret;
+    chunk->discont = discont;
+
+    if (gst_unix_ring_push (src->ring, chunk, FALSE)) {
+      discont = FALSE;
+      continue;
+    }
+
+    /* failures and caps are never dropped */
+    drop = overflow == GST_UNIX_RING_OVERFLOW_DROP && ret == GST_FLOW_OK &&
+        chunk->header.type != GST_UNIX_MESSAGE_CAPS;
+
+    GST_OBJECT_LOCK (src);
+    src->prefetch_full++;
+    if (drop)
+      src->prefetch_dropped++;
+    GST_OBJECT_UNLOCK (src);
+
+    if (drop) {
+      GST_LOG_OBJECT (src, "prefetch ring full, dropping");
+      gst_unix_client_src_chunk_free (chunk);
+      discont = TRUE;
+    } else if (gst_unix_ring_push (src->ring, chunk, TRUE)) {
+      discont = FALSE;
+    } else {
+      /* closed */
+      gst_unix_client_src_chunk_free (chunk);
+      break;
+    }
+  } while (ret == GST_FLOW_OK);
+
+  GST_DEBUG_OBJECT (src, "prefetch thread done: %s", gst_flow_get_name (ret));
+
+  return NULL;
+}
+
+/* get what the prefetch thread read ahead. A failure stays, every later
+ * call returns it again until the connection is replaced */
+static GstFlowReturn
+gst_unix_client_src_pop (GstUNIXClientSrc * src, GstUNIXFrameHeader * header,
+    GstBuffer ** outbuf, GError ** err)
+{
+  GstUNIXClientSrcChunk *chunk;
+  guint level;
+
+  *outbuf = NULL;
+
+  if (G_UNLIKELY (src->prefetch_failed)) {
+    chunk = src->prefetch_failed;
+    if (chunk->error)
+      *err = g_error_copy (chunk->error);
+    return chunk->ret;
+  }
+
+  level = gst_unix_ring_get_level (src->ring);
+  chunk = gst_unix_ring_pop (src->ring);
+  gst_unix_client_src_wait_done (src);
+  if (!chunk)
+    return GST_FLOW_FLUSHING;
+
+  GST_OBJECT_LOCK (src);
+  gst_unix_histogram_record (&src->prefetch_fill, level);
+  GST_OBJECT_UNLOCK (src);
+
+  if (chunk->ret != GST_FLOW_OK) {
+    src->prefetch_failed = chunk;
+    if (chunk->error)
+      *err = g_error_copy (chunk->error);
+    return chunk->ret;
+  }
+
+  if (chunk->discont)
+    src->discont = TRUE;
+  if (header)
+    *header = chunk->header;
+  *outbuf = chunk->buffer;
+  chunk->buffer = NULL;
+  gst_unix_client_src_chunk_free (chunk);
+
+  return GST_FLOW_OK;
+}
+
+/* read the next buffer from the current connection */
+static GstFlowReturn
+gst_unix_client_src_read (GstUNIXClientSrc * src, GstBuffer ** outbuf)
+{
+  GstFlowReturn ret;
+  GError *err = NULL;
+
+  if (src->local) {
+    ret = gst_unix_local_channel_pop (src->local, outbuf);
+    gst_unix_client_src_wait_done (src);
+    if (ret == GST_FLOW_EOS)
+      GST_DEBUG_OBJECT (src, "Local connection closed");
+    return ret;
+  }
+  if (src->stripe)
+    return gst_unix_client_src_create_striped (src, outbuf);
+  if (src->protocol == GST_UNIX_PROTOCOL_FRAMED)
+    return gst_unix_client_src_create_framed (src, outbuf);
+
+  if (src->ring)
+    ret = gst_unix_client_src_pop (src, NULL, outbuf, &err);
+  else
+    ret = gst_unix_client_src_read_raw (src, src->cancellable, outbuf, &err);
+  if (ret != GST_FLOW_OK)
+    return gst_unix_client_src_read_failed (src, ret, &err);
+
+  return GST_FLOW_OK;
+}
+
+/* split the time spent in create() into waiting and reading */
+static void
+gst_unix_client_src_record_timing (GstUNIXClientSrc * src)
+{
+  GstClockTime now = gst_unix_latency_now ();
+
+  GST_OBJECT_LOCK (src);
+  if (GST_CLOCK_TIME_IS_VALID (src->wait_end)) {
+    gst_unix_histogram_record (&src->wait_time,
+        src->wait_end - src->create_start);
+    gst_unix_histogram_record (&src->read_time, now - src->wait_end);
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  src->create_end = now;
+}
+
+/* wait until @timeout_ms passed or something was created in the directory
+ * of our path. Returns FALSE when cancelled */
+static gboolean
+gst_unix_client_src_wait_for_path (GstUNIXClientSrc * src, guint timeout_ms)
+{
+  GPollFD fds[2];
+  gint nfds = 0, res;
+  gboolean ret = TRUE;
+#ifdef __linux__
+  gchar *dir;
+  gint fd;
+
+  fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+  if (fd >= 0) {
+    dir = g_path_get_dirname (gst_unix_client_src_active_path (src));
+    if (inotify_add_watch (fd, dir, IN_CREATE | IN_MOVED_TO | IN_ATTRIB) < 0) {
+      close (fd);
+      fd = -1;
+    }
+    g_free (dir);
+  }
+  if (fd >= 0) {
+    fds[nfds].fd = fd;
+    fds[nfds].events = G_IO_IN;
+    fds[nfds].revents = 0;
+    nfds++;
+  }
+#endif
+
+  if (g_cancellable_make_pollfd (src->cancellable, &fds[nfds]))
+    nfds++;
+
+  res = g_poll (fds, nfds, timeout_ms);
+  if (res < 0 && errno != EINTR)
+    GST_WARNING_OBJECT (src, "poll failed: %s", g_strerror (errno));
+
+  if (g_cancellable_is_cancelled (src->cancellable))
+    ret = FALSE;
+  g_cancellable_release_fd (src->cancellable);
+
+#ifdef __linux__
+  if (fd >= 0)
+    close (fd);
+#endif
+
+  return ret;
+}
+
+/* (re)connect from the streaming thread, backing off exponentially while
+ * the server is not there */
+static GstFlowReturn
+gst_unix_client_src_wait_connect (GstUNIXClientSrc * src)
+{
+  guint backoff = MIN_BACKOFF;
+  GError *err = NULL;
+
+  while (TRUE) {
+    if (gst_unix_client_src_connect (src, &err)) {
+      GST_DEBUG_OBJECT (src, "connected to %s",
+          gst_unix_client_src_active_path (src));
+      return GST_FLOW_OK;
+    }
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      goto cancelled;
+
+    GST_DEBUG_OBJECT (src, "server at %s not there (%s), retrying in %u ms",
+        gst_unix_client_src_active_path (src), err->message, backoff);
+    g_clear_error (&err);
+
+    if (!gst_unix_client_src_wait_for_path (src, backoff))
+      goto cancelled;
+    backoff = MIN (backoff * 2, src->max_backoff);
+  }
+
+cancelled:
+  {
+    GST_DEBUG_OBJECT (src, "Cancelled connecting");
+    g_clear_error (&err);
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+static void
+gst_unix_client_src_close_standby (GstUNIXClientSrc * src)
+{
+  GSocket *standby;
+
+  GST_OBJECT_LOCK (src);
+  standby = src->standby;
+  src->standby = NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  if (standby) {
+    g_socket_close (standby, NULL);
+    g_object_unref (standby);
+  }
+  gst_caps_replace (&src->standby_caps, NULL);
+}
+
+/* keep a connection to the next reachable server as standby. Attempts are
+ * spaced by max-backoff */
+static void
+gst_unix_client_src_open_standby (GstUNIXClientSrc * src)
+{
+  GSocketAddress *usaddr;
+  GstStructure *hello;
+  GSocket *socket;
+  GstClockTime now;
+  GError *err = NULL;
+  guint i;
+
+  if (src->n_paths < 2 || src->standby)
+    return;
+
+  now = gst_util_get_timestamp ();
+  if (now < src->standby_retry)
+    return;
+  src->standby_retry = now + src->max_backoff * GST_MSECOND;
+
+  for (i = 1; i < src->n_paths; i++) {
+    guint index = (src->active + i) % src->n_paths;
+
+    socket = g_socket_new (G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM,
+        G_SOCKET_PROTOCOL_DEFAULT, &err);
+    if (!socket)
+      break;
+    gst_unix_client_src_size_socket (src, socket, 1);
+
+    usaddr = g_unix_socket_address_new (src->paths[index]);
+    if (g_socket_connect (socket, usaddr, src->cancellable, &err) &&
+        src->protocol == GST_UNIX_PROTOCOL_FRAMED) {
+      hello = gst_structure_new ("hello", "standby", G_TYPE_BOOLEAN, TRUE,
+          NULL);
+      gst_unix_client_src_add_rendition (src, hello);
+      gst_unix_protocol_send_hello (socket, hello, src->cancellable, &err);
+      gst_structure_free (hello);
+    }
+    g_object_unref (usaddr);
+
+    if (!err) {
+      GST_INFO_OBJECT (src, "standby connected to %s", src->paths[index]);
+      GST_OBJECT_LOCK (src);
+      src->standby = socket;
+      src->standby_index = index;
+      GST_OBJECT_UNLOCK (src);
+      src->standby_data = GST_CLOCK_TIME_NONE;
+      return;
+    }
+
+    GST_DEBUG_OBJECT (src, "no standby at %s: %s", src->paths[index],
+        err->message);
+    g_clear_error (&err);
+    g_object_unref (socket);
+  }
+  g_clear_error (&err);
+}
+
+/* throw away what the standby received so that it is at the live edge
+ * when we switch over, framed data is dropped frame by frame to keep in
+ * sync */
+static void
+gst_unix_client_src_drain_standby (GstUNIXClientSrc * src)
+{
+  GstFlowReturn ret;
+  GError *err = NULL;
+
+  if (src->protocol == GST_UNIX_PROTOCOL_FRAMED) {
+    GstUNIXFrameHeader header;
+    GstBuffer *buf;
+
+    ret = gst_unix_client_src_read_frame (src, src->standby,
+        src->cancellable, &header, &buf, &err);
+    /* the format is only announced once, remember it for the switch */
+    if (ret == GST_FLOW_OK && header.type == GST_UNIX_MESSAGE_CAPS) {
+      GstCaps *caps = gst_unix_client_src_parse_caps (buf);
+
+      gst_caps_replace (&src->standby_caps, caps);
+      if (caps)
+        gst_caps_unref (caps);
+    }
+    if (buf)
+      gst_buffer_unref (buf);
+  } else {
+    gchar scratch[MAX_READ_SIZE];
+    gssize rret;
+
+    rret = g_socket_receive (src->standby, scratch, sizeof (scratch),
+        src->cancellable, &err);
+    if (rret > 0)
+      ret = GST_FLOW_OK;
+    else if (rret == 0)
+      ret = GST_FLOW_EOS;
+    else if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      ret = GST_FLOW_FLUSHING;
+    else
+      ret = GST_FLOW_ERROR;
+  }
+
+  if (ret == GST_FLOW_OK) {
+    src->standby_data = gst_util_get_timestamp ();
+  } else if (ret != GST_FLOW_FLUSHING) {
+    GST_WARNING_OBJECT (src, "lost standby %s: %s",
+        src->paths[src->standby_index], err ? err->message : "closed");
+    gst_unix_client_src_close_standby (src);
+  }
+  g_clear_error (&err);
+}
+
+/* wait for the active connection to become readable while draining the
+ * standby. Returns GST_UNIX_CLIENT_SRC_FLOW_STALLED when the active server
+ * is silent for stall-timeout while the standby is not */
+static GstFlowReturn
+gst_unix_client_src_wait_primary (GstUNIXClientSrc * src)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GPollFD fds[3];
+  GstClockTime now, deadline;
+  gint nfds, timeout;
+  gboolean cancellable_fd;
+
+  cancellable_fd = g_cancellable_make_pollfd (src->cancellable, &fds[2]);
+
+  while (TRUE) {
+    gst_unix_client_src_open_standby (src);
+
+    fds[0].fd = g_socket_get_fd (src->socket);
+    fds[0].events = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+    fds[0].revents = 0;
+    nfds = 1;
+    if (src->standby) {
+      fds[1].fd = g_socket_get_fd (src->standby);
+      fds[1].events = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+      fds[1].revents = 0;
+      nfds = 2;
+    }
+    if (cancellable_fd) {
+      fds[nfds] = fds[2];
+      fds[nfds].revents = 0;
+      nfds++;
+    }
+
+    now = gst_util_get_timestamp ();
+    if (!src->standby) {
+      /* come back to retry the standby */
+      timeout = src->max_backoff;
+    } else if (src->stall_timeout == 0) {
+      timeout = -1;
+    } else {
+      deadline = src->last_data + src->stall_timeout * GST_MSECOND;
+      if (now >= deadline) {
+        /* only give up on the active server when the standby has newer
+         * data, both being silent is a pause of the stream */
+        if (GST_CLOCK_TIME_IS_VALID (src->standby_data) &&
+            src->standby_data > src->last_data) {
+          ret = GST_UNIX_CLIENT_SRC_FLOW_STALLED;
+          break;
+        }
+        timeout = -1;
+      } else {
+        timeout = (deadline - now + GST_MSECOND - 1) / GST_MSECOND;
+      }
+    }
+
+    if (g_poll (fds, nfds, timeout) < 0 && errno != EINTR)
+      GST_WARNING_OBJECT (src, "poll failed: %s", g_strerror (errno));
+
+    if (g_cancellable_is_cancelled (src->cancellable)) {
+      ret = GST_FLOW_FLUSHING;
+      break;
+    }
+    if (fds[0].revents)
+      break;
+    if (src->standby && fds[1].revents)
+      gst_unix_client_src_drain_standby (src);
+  }
+
+  if (cancellable_fd)
+    g_cancellable_release_fd (src->cancellable);
+
+  return ret;
+}
+
+/* make the standby the active connection */
+static void
+gst_unix_client_src_switch_over (GstUNIXClientSrc * src)
+{
+  GSocket *standby;
+
+  if (!GST_CLOCK_TIME_IS_VALID (src->switch_start))
+    src->switch_start = gst_util_get_timestamp ();
+
+  gst_unix_client_src_disconnect (src);
+
+  GST_OBJECT_LOCK (src);
+  standby = src->standby;
+  src->standby = NULL;
+  src->active = src->standby_index;
+  GST_OBJECT_UNLOCK (src);
+
+  GST_WARNING_OBJECT (src, "switching over to %s", src->paths[src->active]);
+
+  src->socket = standby;
+  if (src->standby_caps) {
+    gst_base_src_set_caps (GST_BASE_SRC (src), src->standby_caps);
+    gst_caps_replace (&src->standby_caps, NULL);
+  }
+  src->last_data = src->switch_start;
+  src->discont = TRUE;
+  /* the old active server might come back, try it as standby right away */
+  src->standby_retry = 0;
+}
+
+static GstFlowReturn
+gst_unix_client_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
+{
+  GstUNIXClientSrc *src;
+  GstFlowReturn ret;
+
+  src = GST_UNIX_CLIENT_SRC (psrc);
+
+  if (!GST_OBJECT_FLAG_IS_SET (src, GST_UNIX_CLIENT_SRC_OPEN))
+    goto wrong_state;
+
+  GST_LOG_OBJECT (src, "asked for a buffer");
+  GST_UNIX_TRACE1 (client_create, src);
+
+  if (G_UNLIKELY (src->trace_timing)) {
+    src->create_start = gst_unix_latency_now ();
+    src->wait_end = GST_CLOCK_TIME_NONE;
+    if (GST_CLOCK_TIME_IS_VALID (src->create_end)) {
+      GST_OBJECT_LOCK (src);
+      gst_unix_histogram_record (&src->downstream_time,
+          src->create_start - src->create_end);
+      GST_OBJECT_UNLOCK (src);
+    }
+  }
+
+  GST_OBJECT_LOCK (src);
+  gst_unix_jitter_update (&src->jitter);
+  GST_OBJECT_UNLOCK (src);
+
+  while (TRUE) {
+    if (!src->connected) {
+      ret = gst_unix_client_src_wait_connect (src);
+      if (ret != GST_FLOW_OK)
+        return ret;
+      src->connected = TRUE;
+
+      if (GST_CLOCK_TIME_IS_VALID (src->disconnect_time)) {
+        GST_OBJECT_LOCK (src);
+        src->reconnects++;
+        src->reconnect_time = gst_util_get_timestamp () - src->disconnect_time;
+        GST_OBJECT_UNLOCK (src);
+        GST_INFO_OBJECT (src, "reconnected after %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (src->reconnect_time));
+        src->disconnect_time = GST_CLOCK_TIME_NONE;
+        src->discont = TRUE;
+      }
+    }
+
+    if (src->n_paths > 1) {
+      ret = gst_unix_client_src_wait_primary (src);
+      if (ret == GST_UNIX_CLIENT_SRC_FLOW_STALLED) {
+        GST_WARNING_OBJECT (src, "no data from %s for %u ms",
+            src->paths[src->active], src->stall_timeout);
+        src->switch_start = src->last_data + src->stall_timeout * GST_MSECOND;
+        gst_unix_client_src_switch_over (src);
+        continue;
+      } else if (ret != GST_FLOW_OK) {
+        return ret;
+      }
+    }
+
+    GST_UNIX_TRACE1 (client_wait_start, src);
+    ret = gst_unix_client_src_read (src, outbuf);
+
+    if (ret == GST_FLOW_OK) {
+      gboolean resize;
+
+      if (G_UNLIKELY (src->trace_timing))
+        gst_unix_client_src_record_timing (src);
+
+      GST_OBJECT_LOCK (src);
+      resize = gst_unix_bitrate_update (&src->bitrate,
+          gst_buffer_get_size (*outbuf)) && src->latency_target &&
+          !src->receive_buffer_size;
+      GST_OBJECT_UNLOCK (src);
+      if (G_UNLIKELY (resize))
+        gst_unix_client_src_resize (src);
+
+      GST_UNIX_TRACE3 (client_push, src, *outbuf,
+          gst_buffer_get_size (*outbuf));
+      if (src->n_paths > 1) {
+        src->last_data = gst_util_get_timestamp ();
+        if (G_UNLIKELY (GST_CLOCK_TIME_IS_VALID (src->switch_start))) {
+          GST_OBJECT_LOCK (src);
+          src->switches++;
+          src->switch_latency = src->last_data - src->switch_start;
+          GST_OBJECT_UNLOCK (src);
+          GST_INFO_OBJECT (src, "switched over in %" GST_TIME_FORMAT,
+              GST_TIME_ARGS (src->switch_latency));
+          src->switch_start = GST_CLOCK_TIME_NONE;
+        }
+      }
+      if (G_UNLIKELY (src->discont)) {
+        GST_BUFFER_FLAG_SET (*outbuf, GST_BUFFER_FLAG_DISCONT);
+        src->discont = FALSE;
+      }
+      return GST_FLOW_OK;
+    }
+
+    if (src->standby && (ret == GST_FLOW_EOS || ret == GST_FLOW_ERROR)) {
+      GST_WARNING_OBJECT (src, "lost %s", src->paths[src->active]);
+      src->switch_start = GST_CLOCK_TIME_NONE;
+      gst_unix_client_src_switch_over (src);
+      continue;
+    }
+
+    if (!src->reconnect || (ret != GST_FLOW_EOS && ret != GST_FLOW_ERROR))
+      return ret;
+
+    /* keep pool, caps and downstream as they are, only the connection is
+     * replaced */
+    GST_DEBUG_OBJECT (src, "lost connection, reconnecting");
+    gst_unix_client_src_disconnect (src);
+    src->connected = FALSE;
+    src->disconnect_time = gst_util_get_timestamp ();
+  }
+
+wrong_state:
+  {
+    GST_DEBUG_OBJECT (src, "connection to closed, cannot read data");
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+static void
+gst_unix_client_src_set_paths (GstUNIXClientSrc * src, const gchar * paths)
+{
+  gchar **split;
+  guint i, n = 0;
+
+  split = g_strsplit (paths ? paths : "", ",", -1);
+  for (i = 0; split[i]; i++) {
+    g_strstrip (split[i]);
+    if (*split[i])
+      split[n++] = split[i];
+    else
+      g_free (split[i]);
+  }
+  split[n] = NULL;
+
+  GST_OBJECT_LOCK (src);
+  g_strfreev (src->paths);
+  src->paths = n ? split : NULL;
+  src->n_paths = n;
+  src->active = 0;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!n)
+    g_free (split);
+}
+
+static GstStructure *
+gst_unix_client_src_get_stats (GstUNIXClientSrc * src)
+{
+  GstStructure *s;
+  guint i;
+
+  s = gst_structure_new_empty ("GstUNIXClientSrcStats");
+
+  GST_OBJECT_LOCK (src);
+  gst_unix_jitter_add_to_structure (&src->jitter, s, "create");
+  gst_unix_histogram_add_to_structure (&src->latency, s, "latency");
+  if (src->trace_timing) {
+    gst_unix_histogram_add_to_structure (&src->wait_time, s, "wait-time");
+    gst_unix_histogram_add_to_structure (&src->read_time, s, "read-time");
+    gst_unix_histogram_add_to_structure (&src->downstream_time, s,
+        "downstream-time");
+  }
+  gst_structure_set (s, "reconnects", G_TYPE_UINT64, src->reconnects,
+      "last-reconnect-time", G_TYPE_UINT64, src->reconnect_time, NULL);
+  gst_structure_set (s, "bitrate", G_TYPE_UINT64, src->bitrate.rate,
+      "receive-buffer-size", G_TYPE_INT, src->rcvbuf_applied, NULL);
+  if (src->paths) {
+    gst_structure_set (s, "active-path", G_TYPE_STRING,
+        src->paths[src->active], "standby", G_TYPE_BOOLEAN,
+        src->standby != NULL, "switches", G_TYPE_UINT64, src->switches,
+        "last-switch-latency", G_TYPE_UINT64, src->switch_latency, NULL);
+  }
+  if (src->ring) {
+    gst_structure_set (s, "prefetch-size", G_TYPE_UINT,
+        gst_unix_ring_get_size (src->ring), "prefetch-level", G_TYPE_UINT,
+        gst_unix_ring_get_level (src->ring), "prefetch-full", G_TYPE_UINT64,
+        src->prefetch_full, "prefetch-dropped", G_TYPE_UINT64,
+        src->prefetch_dropped, NULL);
+    gst_unix_histogram_add_to_structure (&src->prefetch_fill, s,
+        "prefetch-fill");
+  }
+  if (src->stripe) {
+    for (i = 0; i < src->stripes; i++) {
+      gchar *prefix = g_strdup_printf ("stripe%u", i);
+
+      gst_unix_jitter_add_to_structure (&src->stripe[i].jitter, s, prefix);
+      g_free (prefix);
+    }
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  return s;
+}
+
+static void
+gst_unix_client_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstUNIXClientSrc *unixclientsrc = GST_UNIX_CLIENT_SRC (object);
+
+  switch (prop_id) {
+    case PROP_PATH:
+      if (!g_value_get_string (value)) {
+        g_warning ("path property cannot be NULL");
+        break;
+      }
+      g_free (unixclientsrc->path);
+      unixclientsrc->path = g_strdup (g_value_get_string (value));
+      break;
+    case PROP_PROTOCOL:
+      unixclientsrc->protocol = g_value_get_enum (value);
+      break;
+    case PROP_STRIPES:
+      unixclientsrc->stripes = g_value_get_uint (value);
+      break;
+    case PROP_ALIGNMENT:{
+      guint alignment = g_value_get_uint (value);
+
+      if (alignment & (alignment - 1)) {
+        g_warning ("alignment must be a power of two");
+        break;
+      }
+      unixclientsrc->alignment = alignment;
+      break;
+    }
+    case PROP_HUGE_PAGES:
+      unixclientsrc->huge_pages = g_value_get_enum (value);
+      break;
+    case PROP_LATENCY_META:
+      unixclientsrc->latency_meta = g_value_get_boolean (value);
+      break;
+    case PROP_IN_PROCESS:
+      unixclientsrc->in_process = g_value_get_boolean (value);
+      break;
+    case PROP_WAIT_FOR_SERVER:
+      unixclientsrc->wait_for_server = g_value_get_boolean (value);
+      break;
+    case PROP_RECONNECT:
+      unixclientsrc->reconnect = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_BACKOFF:
+      unixclientsrc->max_backoff = g_value_get_uint (value);
+      break;
+    case PROP_PATHS:
+      gst_unix_client_src_set_paths (unixclientsrc, g_value_get_string (value));
+      break;
+    case PROP_STALL_TIMEOUT:
+      unixclientsrc->stall_timeout = g_value_get_uint (value);
+      break;
+    case PROP_RENDITION:
+      GST_OBJECT_LOCK (unixclientsrc);
+      gst_caps_replace (&unixclientsrc->rendition, g_value_get_boxed (value));
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_TRACE_TIMING:
+      unixclientsrc->trace_timing = g_value_get_boolean (value);
+      break;
+    case PROP_CAPTURE_LOCATION:
+      g_free (unixclientsrc->capture_location);
+      unixclientsrc->capture_location = g_value_dup_string (value);
+      break;
+    case PROP_PREFETCH:
+      unixclientsrc->prefetch = g_value_get_uint (value);
+      break;
+    case PROP_LATENCY_TARGET:
+      GST_OBJECT_LOCK (unixclientsrc);
+      unixclientsrc->latency_target = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+      GST_OBJECT_LOCK (unixclientsrc);
+      unixclientsrc->receive_buffer_size = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_SENDER_THREAD:
+      unixclientsrc->sender_thread = g_value_get_boolean (value);
+      break;
+    case PROP_PREFETCH_OVERFLOW:
+      GST_OBJECT_LOCK (unixclientsrc);
+      unixclientsrc->prefetch_overflow = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_CPU_AFFINITY:
+      GST_OBJECT_LOCK (unixclientsrc);
+      g_free (unixclientsrc->thread_config.cpus);
+      unixclientsrc->thread_config.cpus = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_SCHED_POLICY:
+      GST_OBJECT_LOCK (unixclientsrc);
+      unixclientsrc->thread_config.policy = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_SCHED_PRIORITY:
+      GST_OBJECT_LOCK (unixclientsrc);
+      unixclientsrc->thread_config.priority = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_unix_client_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstUNIXClientSrc *unixclientsrc = GST_UNIX_CLIENT_SRC (object);
+
+  switch (prop_id) {
+    case PROP_PATH:
+      g_value_set_string (value, unixclientsrc->path);
+      break;
+    case PROP_PROTOCOL:
+      g_value_set_enum (value, unixclientsrc->protocol);
+      break;
+    case PROP_STRIPES:
+      g_value_set_uint (value, unixclientsrc->stripes);
+      break;
+    case PROP_ALIGNMENT:
+      g_value_set_uint (value, unixclientsrc->alignment);
+      break;
+    case PROP_HUGE_PAGES:
+      g_value_set_enum (value, unixclientsrc->huge_pages);
+      break;
+    case PROP_CPU_AFFINITY:
+      GST_OBJECT_LOCK (unixclientsrc);
+      g_value_set_string (value, unixclientsrc->thread_config.cpus);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_SCHED_POLICY:
+      g_value_set_enum (value, unixclientsrc->thread_config.policy);
+      break;
+    case PROP_SCHED_PRIORITY:
+      g_value_set_int (value, unixclientsrc->thread_config.priority);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_unix_client_src_get_stats (unixclientsrc));
+      break;
+    case PROP_LATENCY_META:
+      g_value_set_boolean (value, unixclientsrc->latency_meta);
+      break;
+    case PROP_IN_PROCESS:
+      g_value_set_boolean (value, unixclientsrc->in_process);
+      break;
+    case PROP_WAIT_FOR_SERVER:
+      g_value_set_boolean (value, unixclientsrc->wait_for_server);
+      break;
+    case PROP_RECONNECT:
+      g_value_set_boolean (value, unixclientsrc->reconnect);
+      break;
+    case PROP_MAX_BACKOFF:
+      g_value_set_uint (value, unixclientsrc->max_backoff);
+      break;
+    case PROP_PATHS:
+      GST_OBJECT_LOCK (unixclientsrc);
+      g_value_take_string (value, unixclientsrc->paths ?
+          g_strjoinv (",", unixclientsrc->paths) : NULL);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_STALL_TIMEOUT:
+      g_value_set_uint (value, unixclientsrc->stall_timeout);
+      break;
+    case PROP_RENDITION:
+      GST_OBJECT_LOCK (unixclientsrc);
+      g_value_set_boxed (value, unixclientsrc->rendition);
+      GST_OBJECT_UNLOCK (unixclientsrc);
+      break;
+    case PROP_TRACE_TIMING:
+      g_value_set_boolean (value, unixclientsrc->trace_timing);
+      break;
+    case PROP_CAPTURE_LOCATION:
+      g_value_set_string (value, unixclientsrc->capture_location);
+      break;
+    case PROP_PREFETCH:
+      g_value_set_uint (value, unixclientsrc->prefetch);
+      break;
+    case PROP_LATENCY_TARGET:
+      g_value_set_uint (value, unixclientsrc->latency_target);
+      break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+      g_value_set_int (value, unixclientsrc->receive_buffer_size);
+      break;
+    case PROP_SENDER_THREAD:
+      g_value_set_boolean (value, unixclientsrc->sender_thread);
+      break;
+    case PROP_PREFETCH_OVERFLOW:
+      g_value_set_enum (value, unixclientsrc->prefetch_overflow);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* send the hello of every connection and, for striped reception, open the
+ * additional connections and start their reader threads */
+static gboolean
+gst_unix_client_src_start_framed (GstUNIXClientSrc * src,
+    GSocketAddress * usaddr, GError ** err)
+{
+  GstStructure *hello;
+  guint64 group;
+  gboolean ret = TRUE;
+  guint i;
+
+  group = ((guint64) g_random_int () << 32) | g_random_int ();
+
+  if (src->stripes > 1) {
+    src->stripe = g_new0 (GstUNIXClientSrcStripe, src->stripes);
+    src->stripe_cancellable = g_cancellable_new ();
+    src->stripe_flushing = FALSE;
+  }
+
+  for (i = 0; i < src->stripes && ret; i++) {
+    GSocket *socket;
+
+    if (i == 0) {
+      socket = g_object_ref (src->socket);
+    } else {
+      socket = g_socket_new (G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM,
+          G_SOCKET_PROTOCOL_DEFAULT, err);
+      if (!socket)
+        return FALSE;
+      gst_unix_client_src_size_socket (src, socket, src->stripes);
+      if (!g_socket_connect (socket, usaddr, src->cancellable, err)) {
+        g_object_unref (socket);
+        return FALSE;
+      }
+    }
+
+    hello = gst_structure_new_empty ("hello");
+    gst_unix_client_src_add_rendition (src, hello);
+    /* a group of one stripe gets a sender thread of its own */
+    if (src->stripe || src->sender_thread) {
+      gst_structure_set (hello, "stripe-group", G_TYPE_UINT64, group,
+          "stripe-index", G_TYPE_UINT, i, "stripe-count", G_TYPE_UINT,
+          src->stripes, NULL);
+    }
+    ret = gst_unix_protocol_send_hello (socket, hello, src->cancellable, err);
+    gst_structure_free (hello);
+
+    if (src->stripe) {
+      src->stripe[i].src = src;
+      src->stripe[i].index = i;
+      src->stripe[i].socket = socket;
+      g_queue_init (&src->stripe[i].queue);
+      gst_unix_jitter_reset (&src->stripe[i].jitter);
+    } else {
+      g_object_unref (socket);
+    }
+  }
+  if (!ret || !src->stripe)
+    return ret;
+
+  for (i = 0; i < src->stripes; i++)
+    src->stripe[i].thread = g_thread_new ("unixclientsrc-stripe",
+        (GThreadFunc) gst_unix_client_src_stripe_thread, &src->stripe[i]);
+
+  GST_DEBUG_OBJECT (src, "receiving over %u stripes", src->stripes);
+
+  return TRUE;
+}
+
+static void
+gst_unix_client_src_stop_stripes (GstUNIXClientSrc * src)
+{
+  GstUNIXClientSrcChunk *chunk;
+  guint i;
+
+  if (!src->stripe)
+    return;
+
+  g_cancellable_cancel (src->stripe_cancellable);
+  g_mutex_lock (&src->stripe_lock);
+  g_cond_broadcast (&src->stripe_cond);
+  g_mutex_unlock (&src->stripe_lock);
+
+  for (i = 0; i < src->stripes; i++) {
+    GstUNIXClientSrcStripe *stripe = &src->stripe[i];
+
+    if (stripe->thread)
+      g_thread_join (stripe->thread);
+    while ((chunk = g_queue_pop_head (&stripe->queue)))
+      gst_unix_client_src_chunk_free (chunk);
+    if (stripe->socket) {
+      g_socket_close (stripe->socket, NULL);
+      g_object_unref (stripe->socket);
+    }
+  }
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->stripe);
+  src->stripe = NULL;
+  GST_OBJECT_UNLOCK (src);
+  g_object_unref (src->stripe_cancellable);
+  src->stripe_cancellable = NULL;
+}
+
+static void
+gst_unix_client_src_start_prefetch (GstUNIXClientSrc * src)
+{
+  src->prefetch_cancellable = g_cancellable_new ();
+  gst_unix_ring_set_closed (src->ring, FALSE);
+  src->prefetch_thread = g_thread_new ("unixclientsrc-prefetch",
+      (GThreadFunc) gst_unix_client_src_prefetch_thread, src);
+
+  GST_DEBUG_OBJECT (src, "prefetching up to %u buffers",
+      gst_unix_ring_get_size (src->ring));
+}
+
+/* stop the prefetch thread and drop what it read ahead */
+static void
+gst_unix_client_src_stop_prefetch (GstUNIXClientSrc * src)
+{
+  if (src->prefetch_thread) {
+    g_cancellable_cancel (src->prefetch_cancellable);
+    gst_unix_ring_set_closed (src->ring, TRUE);
+    g_thread_join (src->prefetch_thread);
+    src->prefetch_thread = NULL;
+    g_object_unref (src->prefetch_cancellable);
+    src->prefetch_cancellable = NULL;
+  }
+  if (src->ring)
+    gst_unix_ring_clear (src->ring,
+        (GDestroyNotify) gst_unix_client_src_chunk_free);
+  if (src->prefetch_failed) {
+    gst_unix_client_src_chunk_free (src->prefetch_failed);
+    src->prefetch_failed = NULL;
+  }
+}
+
+/* close the connection, in this process or through the socket, but keep
+ * everything else */
+static void
+gst_unix_client_src_disconnect (GstUNIXClientSrc * src)
+{
+  GstUNIXLocalChannel *local;
+  GError *err = NULL;
+
+  gst_unix_client_src_stop_stripes (src);
+  gst_unix_client_src_stop_prefetch (src);
+
+  GST_OBJECT_LOCK (src);
+  local = src->local;
+  src->local = NULL;
+  GST_OBJECT_UNLOCK (src);
+  if (local)
+    gst_unix_local_channel_close (local);
+
+  if (src->socket) {
+    GST_DEBUG_OBJECT (src, "closing socket");
+
+    if (!g_socket_close (src->socket, &err)) {
+      GST_ERROR_OBJECT (src, "Failed to close socket: %s", err->message);
+      g_clear_error (&err);
+    }
+    g_object_unref (src->socket);
+    src->socket = NULL;
+  }
+}
+
+/* whether a server in this process may hand us its buffers directly.
+ * Local channels cannot be watched for stalls, failover needs sockets, and
+ * there are no bytes to capture. They also carry the sink's buffers as they
+ * are, without the caps, send times and conversion of the framed protocol,
+ * and without stripes */
+static gboolean
+gst_unix_client_src_can_go_local (GstUNIXClientSrc * src)
+{
+  return src->in_process && !src->paths && !src->capture &&
+      src->protocol == GST_UNIX_PROTOCOL_RAW && !src->rendition &&
+      src->stripes <= 1;
+}
+
+/* connect to the server at @path, in this process or through the socket */
+static gboolean
+gst_unix_client_src_connect_path (GstUNIXClientSrc * src, const gchar * path,
+    GError ** err)
+{
+  GSocketAddress *usaddr;
+  GstUNIXLocalChannel *local;
+
+  if (gst_unix_client_src_can_go_local (src) &&
+      (local = gst_unix_local_connect (path))) {
+    GST_DEBUG_OBJECT (src, "connected to %s in this process", path);
+    /* we might have been unlocked while connecting */
+    if (g_cancellable_is_cancelled (src->cancellable))
+      gst_unix_local_channel_set_flushing (local, TRUE);
+    GST_OBJECT_LOCK (src);
+    src->local = local;
+    GST_OBJECT_UNLOCK (src);
+    return TRUE;
+  }
+
+  usaddr = g_unix_socket_address_new (path);
+
+  /* create receiving client socket */
+  GST_DEBUG_OBJECT (src, "opening receiving client socket at %s", path);
+
+  src->socket =
+      g_socket_new (G_SOCKET_FAMILY_UNIX, G_SOCKET_TYPE_STREAM,
+      G_SOCKET_PROTOCOL_DEFAULT, err);
+  if (!src->socket)
+    goto failed;
+  gst_unix_client_src_size_socket (src, src->socket, src->stripes);
+
+  GST_DEBUG_OBJECT (src, "opened receiving client socket at %s", path);
+
+  /* connect to server */
+  if (!g_socket_connect (src->socket, usaddr, src->cancellable, err))
+    goto failed;
+  GST_DEBUG_OBJECT (src, "connected to socket at %s", path);
+
+  if (src->protocol == GST_UNIX_PROTOCOL_FRAMED &&
+      !gst_unix_client_src_start_framed (src, usaddr, err))
+    goto failed;
+
+  if (src->ring)
+    gst_unix_client_src_start_prefetch (src);
+
+  g_object_unref (usaddr);
+
+  return TRUE;
+
+failed:
+  {
+    g_object_unref (usaddr);
+    gst_unix_client_src_disconnect (src);
+    return FALSE;
+  }
+}
+
+/* connect to the server. With several paths every one is tried once,
+ * starting with the active one. Errors are returned, not posted */
+static gboolean
+gst_unix_client_src_connect (GstUNIXClientSrc * src, GError ** err)
+{
+  guint i;
+
+  if (!src->paths)
+    return gst_unix_client_src_connect_path (src, src->path, err);
+
+  for (i = 0; i < src->n_paths; i++) {
+    guint index = (src->active + i) % src->n_paths;
+
+    g_clear_error (err);
+    if (gst_unix_client_src_connect_path (src, src->paths[index], err)) {
+      GST_OBJECT_LOCK (src);
+      src->active = index;
+      GST_OBJECT_UNLOCK (src);
+      src->last_data = gst_util_get_timestamp ();
+      return TRUE;
+    }
+    if (g_error_matches (*err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      break;
+  }
+  return FALSE;
+}
+
+/* create a socket for connecting to remote server */
+static gboolean
+gst_unix_client_src_start (GstBaseSrc * bsrc)
+{
+  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (bsrc);
+  GError *err = NULL;
+
+  if (src->stripes > 1 && src->protocol != GST_UNIX_PROTOCOL_FRAMED)
+    goto stripes_need_framing;
+  if (src->stripes > 1 && src->n_paths > 1)
+    goto stripes_and_failover;
+  if (src->rendition && (src->protocol != GST_UNIX_PROTOCOL_FRAMED ||
+          src->stripes > 1))
+    goto rendition_needs_framing;
+  if (src->capture_location && src->stripes > 1)
+    goto capture_and_stripes;
+  if (src->prefetch && (src->stripes > 1 || src->n_paths > 1))
+    goto prefetch_unsupported;
+
+  if (src->capture_location) {
+    src->capture = gst_unix_capture_new (src->capture_location,
+        src->protocol == GST_UNIX_PROTOCOL_FRAMED ?
+        GST_UNIX_CAPTURE_FLAG_FRAMED : 0, &err);
+    if (!src->capture)
+      goto capture_failed;
+  }
+
+  /* stripes have their reader threads already */
+  if (src->prefetch)
+    src->ring = gst_unix_ring_new (src->prefetch);
+
+  /* the default allocator already honours the alignment */
+  gst_allocation_params_init (&src->params);
+  src->params.align = src->alignment ? src->alignment - 1 : 0;
+  if (src->huge_pages != GST_UNIX_HUGE_PAGES_NONE)
+    src->allocator = gst_unix_allocator_new (src->huge_pages);
+
+  GST_OBJECT_LOCK (src);
+  gst_unix_jitter_reset (&src->jitter);
+  gst_unix_histogram_reset (&src->latency);
+  src->reconnects = 0;
+  src->reconnect_time = 0;
+  src->switches = 0;
+  src->switch_latency = 0;
+  gst_unix_histogram_reset (&src->wait_time);
+  gst_unix_histogram_reset (&src->read_time);
+  gst_unix_histogram_reset (&src->downstream_time);
+  gst_unix_histogram_reset (&src->prefetch_fill);
+  src->prefetch_full = 0;
+  src->prefetch_dropped = 0;
+  gst_unix_bitrate_reset (&src->bitrate);
+  src->rcvbuf = 0;
+  src->rcvbuf_applied = 0;
+  src->rcvbuf_clamped = FALSE;
+  GST_OBJECT_UNLOCK (src);
+  src->create_end = GST_CLOCK_TIME_NONE;
+  src->standby_retry = 0;
+  src->switch_start = GST_CLOCK_TIME_NONE;
+  src->standby_data = GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_FLAG_SET (src, GST_UNIX_CLIENT_SRC_OPEN);
+  src->connected = FALSE;
+  src->discont = FALSE;
+  src->disconnect_time = GST_CLOCK_TIME_NONE;
+
+  /* leave connecting to the streaming thread */
+  if (src->wait_for_server) {
+    GST_DEBUG_OBJECT (src, "waiting for server at %s", src->path);
+    return TRUE;
+  }
+
+  if (!gst_unix_client_src_connect (src, &err))
+    goto connect_failed;
+  src->connected = TRUE;
+
+  return TRUE;
+
+stripes_need_framing:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("stripes > 1 needs protocol=framed"));
+    return FALSE;
+  }
+stripes_and_failover:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("stripes > 1 cannot be combined with several paths"));
+    return FALSE;
+  }
+rendition_needs_framing:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("rendition needs protocol=framed and a single stripe"));
+    return FALSE;
+  }
+capture_and_stripes:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("capture-location cannot be combined with stripes > 1"));
+    return FALSE;
+  }
+prefetch_unsupported:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("prefetch cannot be combined with stripes > 1 or several paths"));
+    return FALSE;
+  }
+capture_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_WRITE, (NULL),
+        ("Failed to open capture file: %s", err->message));
+    g_clear_error (&err);
+    return FALSE;
+  }
+connect_failed:
+  {
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      GST_DEBUG_OBJECT (src, "Cancelled connecting");
+    } else {
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+          ("Failed to connect to socket at '%s': %s", src->path, err->message));
+    }
+    g_clear_error (&err);
+    gst_unix_client_src_stop (GST_BASE_SRC (src));
+    return FALSE;
+  }
+}
+
+/* close the socket and associated resources
+ * unset OPEN flag
+ * used both to recover from errors and go to NULL state */
+static gboolean
+gst_unix_client_src_stop (GstBaseSrc * bsrc)
+{
+  GstUNIXClientSrc *src;
+
+  src = GST_UNIX_CLIENT_SRC (bsrc);
+
+  gst_unix_client_src_close_standby (src);
+  gst_unix_client_src_disconnect (src);
+  src->connected = FALSE;
+
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+    src->pool_size = 0;
+  }
+  if (src->allocator) {
+    gst_object_unref (src->allocator);
+    src->allocator = NULL;
+  }
+  if (src->capture) {
+    gst_unix_capture_free (src->capture);
+    src->capture = NULL;
+  }
+  if (src->ring) {
+    GST_OBJECT_LOCK (src);
+    gst_unix_ring_free (src->ring,
+        (GDestroyNotify) gst_unix_client_src_chunk_free);
+    src->ring = NULL;
+    GST_OBJECT_UNLOCK (src);
+  }
+
+  GST_OBJECT_FLAG_UNSET (src, GST_UNIX_CLIENT_SRC_OPEN);
+
+  return TRUE;
+}
+
+/* will be called only between calls to start() and stop() */
+static gboolean
+gst_unix_client_src_unlock (GstBaseSrc * bsrc)
+{
+  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (bsrc);
+  GstUNIXLocalChannel *local;
+
+  GST_DEBUG_OBJECT (src, "set to flushing");
+  g_cancellable_cancel (src->cancellable);
+
+  /* the streaming thread may be closing the channel concurrently */
+  GST_OBJECT_LOCK (src);
+  local = src->local ? gst_unix_local_channel_ref (src->local) : NULL;
+  GST_OBJECT_UNLOCK (src);
+  if (local) {
+    gst_unix_local_channel_set_flushing (local, TRUE);
+    gst_unix_local_channel_unref (local);
+  }
+  if (src->ring)
+    gst_unix_ring_set_flushing (src->ring, TRUE);
+
+  g_mutex_lock (&src->stripe_lock);
+  src->stripe_flushing = TRUE;
+  g_cond_broadcast (&src->stripe_cond);
+  g_mutex_unlock (&src->stripe_lock);
+
+  return TRUE;
+}
+
+/* will be called only between calls to start() and stop() */
+static gboolean
+gst_unix_client_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstUNIXClientSrc *src = GST_UNIX_CLIENT_SRC (bsrc);
+  GstUNIXLocalChannel *local;
+
+  GST_DEBUG_OBJECT (src, "unset flushing");
+  g_cancellable_reset (src->cancellable);
+
+  GST_OBJECT_LOCK (src);
+  local = src->local ? gst_unix_local_channel_ref (src->local) : NULL;
+  GST_OBJECT_UNLOCK (src);
+  if (local) {
+    gst_unix_local_channel_set_flushing (local, FALSE);
+    gst_unix_local_channel_unref (local);
+  }
+  if (src->ring)
+    gst_unix_ring_set_flushing (src->ring, FALSE);
+
+  g_mutex_lock (&src->stripe_lock);
+  src->stripe_flushing = FALSE;
+  g_mutex_unlock (&src->stripe_lock);
 
   return TRUE;
 }
@@ -27,6 +27,15 @@
 
 #include <gio/gio.h>
 
+#include "gstunixprotocol.h"
+#include "gstunixallocator.h"
+#include "gstunixthread.h"
+#include "gstunixlatency.h"
+#include "gstunixlocal.h"
+#include "gstunixcapture.h"
+#include "gstunixring.h"
+#include "gstunixsockbuf.h"
+
 #define UNIX_DEFAULT_PATH "/tmp/gst-unix.sock"
 
 G_BEGIN_DECLS
@@ -44,6 +53,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstUNIXClientSrc GstUNIXClientSrc;
 typedef struct _GstUNIXClientSrcClass GstUNIXClientSrcClass;
+typedef struct _GstUNIXClientSrcStripe GstUNIXClientSrcStripe;
 
 typedef enum {
   GST_UNIX_CLIENT_SRC_OPEN       = (GST_BASE_SRC_FLAG_LAST << 0),
@@ -58,6 +68,100 @@ struct _GstUNIXClientSrc {
   gchar *path;
   GSocket *socket;
   GCancellable *cancellable;
+
+  GstUNIXProtocol protocol;
+  guint stripes;
+  gboolean sender_thread;
+
+  /* striped reception, queues protected by stripe_lock */
+  GstUNIXClientSrcStripe *stripe;
+  GMutex stripe_lock;
+  GCond stripe_cond;
+  GCancellable *stripe_cancellable;
+  gboolean stripe_flushing;
+
+  /* received buffers */
+  guint alignment;
+  GstUNIXHugePages huge_pages;
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstBufferPool *pool;
+  gsize pool_size;
+
+  /* I/O thread placement */
+  GstUNIXThreadConfig thread_config;
+  GstTaskPool *task_pool;       /* threads of the streaming task */
+  GstUNIXJitter jitter;
+
+  /* transport latency, protected by the object lock */
+  gboolean latency_meta;
+  GstUNIXHistogram latency;
+
+  /* server in this process */
+  gboolean in_process;
+  GstUNIXLocalChannel *local;   /* protected by the object lock */
+
+  /* connection management */
+  gboolean wait_for_server;
+  gboolean reconnect;
+  guint max_backoff;
+  gboolean connected;
+  gboolean discont;
+  GstClockTime disconnect_time;
+  guint64 reconnects;           /* protected by the object lock */
+  GstClockTime reconnect_time;  /* protected by the object lock */
+
+  /* failover between redundant servers, paths, active and standby are
+   * protected by the object lock */
+  gchar **paths;
+  guint n_paths;
+  guint active;
+  guint stall_timeout;
+  GSocket *standby;
+  guint standby_index;
+  GstClockTime standby_retry;
+  GstClockTime last_data;
+  GstClockTime standby_data;
+  GstClockTime switch_start;
+  guint64 switches;             /* protected by the object lock */
+  GstClockTime switch_latency;  /* protected by the object lock */
+  GstCaps *standby_caps;
+
+  /* format the server converts to, protected by the object lock */
+  GstCaps *rendition;
+
+  /* timing breakdown, histograms protected by the object lock */
+  gboolean trace_timing;
+  GstClockTime create_start;
+  GstClockTime create_end;
+  GstClockTime wait_end;
+  GstUNIXHistogram wait_time;
+  GstUNIXHistogram read_time;
+  GstUNIXHistogram downstream_time;
+
+  /* recording for gst-unix-replay */
+  gchar *capture_location;
+  GstUNIXCapture *capture;
+
+  /* reading ahead from a thread of its own, ring and stats protected by
+   * the object lock for get_stats */
+  guint prefetch;
+  GstUNIXRingOverflow prefetch_overflow;
+  GstUNIXRing *ring;
+  GThread *prefetch_thread;
+  GCancellable *prefetch_cancellable;
+  gpointer prefetch_failed;
+  GstUNIXHistogram prefetch_fill;
+  guint64 prefetch_full;
+  guint64 prefetch_dropped;
+
+  /* socket buffer sizing, protected by the object lock */
+  guint latency_target;
+  gint receive_buffer_size;
+  gint rcvbuf;
+  gint rcvbuf_applied;          /* granted by the kernel */
+  gboolean rcvbuf_clamped;
+  GstUNIXBitrate bitrate;
 };
 
 struct _GstUNIXClientSrcClass {
@@ -0,0 +1,52 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_CLIENT_WIRE_H__
+#define __GST_UNIX_CLIENT_WIRE_H__
+
+/* Wire format as seen by the standalone client library, which cannot use
+ * the GLib types of gstunixprotocol.h. Not installed; gstunixprotocol.c
+ * includes it too and checks both stay in sync. */
+
+#include <stdint.h>
+
+#include "gstunixclient.h"
+
+#define GST_UNIX_CLIENT_MESSAGE_HELLO   1
+#define GST_UNIX_CLIENT_MESSAGE_BUFFER  2
+#define GST_UNIX_CLIENT_MESSAGE_CAPS    3
+
+/* same layout as GstUNIXFrameHeader */
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t type;
+  uint32_t flags;
+  uint32_t size;
+  uint64_t seq;
+  uint64_t offset;
+  uint64_t total_size;
+  uint64_t pts;
+  uint64_t duration;
+  uint64_t send_time;
+} GstUNIXClientHeader;
+
+#endif /* __GST_UNIX_CLIENT_WIRE_H__ */
@@ -0,0 +1,213 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Transport latency measurement. unixserversink stamps framed buffers with
+ * the CLOCK_MONOTONIC time it got them; both ends run on the same host, so
+ * unixclientsrc can subtract that from its own monotonic time. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <time.h>
+
+#include "gstunixlatency.h"
+
+GstClockTime
+gst_unix_latency_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+static guint
+gst_unix_histogram_index (guint64 value)
+{
+  guint shift;
+
+  if (value < GST_UNIX_HISTOGRAM_SUB_BUCKETS)
+    return value;
+
+  shift = g_bit_nth_msf (value, -1) - GST_UNIX_HISTOGRAM_SUB_BITS;
+
+  return (shift + 1) * GST_UNIX_HISTOGRAM_SUB_BUCKETS +
+      ((value >> shift) & (GST_UNIX_HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/* highest value that ends up in bucket @index */
+static guint64
+gst_unix_histogram_value (guint index)
+{
+  guint shift, sub;
+
+  if (index < GST_UNIX_HISTOGRAM_SUB_BUCKETS)
+    return index;
+
+  shift = index / GST_UNIX_HISTOGRAM_SUB_BUCKETS - 1;
+  sub = index % GST_UNIX_HISTOGRAM_SUB_BUCKETS;
+
+  return (((guint64) GST_UNIX_HISTOGRAM_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void
+gst_unix_histogram_reset (GstUNIXHistogram * hist)
+{
+  memset (hist, 0, sizeof (GstUNIXHistogram));
+  hist->min = G_MAXUINT64;
+}
+
+void
+gst_unix_histogram_record (GstUNIXHistogram * hist, guint64 value)
+{
+  hist->buckets[gst_unix_histogram_index (value)]++;
+  hist->count++;
+  hist->total += value;
+  hist->min = MIN (hist->min, value);
+  hist->max = MAX (hist->max, value);
+}
+
+/* @percentile between 0 and 100 */
+guint64
+gst_unix_histogram_percentile (const GstUNIXHistogram * hist,
+    gdouble percentile)
+{
+  guint64 target, seen = 0;
+  guint i;
+
+  if (hist->count == 0)
+    return 0;
+
+  target = MAX (1, (guint64) (hist->count * percentile / 100.0 + 0.5));
+
+  for (i = 0; i < GST_UNIX_HISTOGRAM_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= target)
+      return MIN (gst_unix_histogram_value (i), hist->max);
+  }
+  return hist->max;
+}
+
+void
+gst_unix_histogram_add_to_structure (const GstUNIXHistogram * hist,
+    GstStructure * s, const gchar * prefix)
+{
+  static const struct
+  {
+    const gchar *name;
+    gdouble percentile;
+  } percentiles[] = {
+    {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}
+  };
+  gchar *name;
+  guint i;
+
+  name = g_strdup_printf ("%s-count", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT64, hist->count, NULL);
+  g_free (name);
+  name = g_strdup_printf ("%s-min", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT64, hist->count ? hist->min : 0,
+      NULL);
+  g_free (name);
+  name = g_strdup_printf ("%s-max", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT64, hist->max, NULL);
+  g_free (name);
+  name = g_strdup_printf ("%s-mean", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT64,
+      hist->count ? hist->total / hist->count : 0, NULL);
+  g_free (name);
+
+  for (i = 0; i < G_N_ELEMENTS (percentiles); i++) {
+    name = g_strdup_printf ("%s-%s", prefix, percentiles[i].name);
+    gst_structure_set (s, name, G_TYPE_UINT64,
+        gst_unix_histogram_percentile (hist, percentiles[i].percentile), NULL);
+    g_free (name);
+  }
+}
+
+GType
+gst_unix_latency_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstUNIXLatencyMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+static gboolean
+gst_unix_latency_meta_init (GstMeta * meta, gpointer params,
+    GstBuffer * buffer)
+{
+  GstUNIXLatencyMeta *lmeta = (GstUNIXLatencyMeta *) meta;
+
+  lmeta->send_time = GST_CLOCK_TIME_NONE;
+  lmeta->latency = GST_CLOCK_TIME_NONE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_unix_latency_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstUNIXLatencyMeta *lmeta = (GstUNIXLatencyMeta *) meta;
+
+  /* the measurement stays valid for copies and sub buffers */
+  gst_buffer_add_unix_latency_meta (dest, lmeta->send_time, lmeta->latency);
+
+  return TRUE;
+}
+
+const GstMetaInfo *
+gst_unix_latency_meta_get_info (void)
+{
+  static const GstMetaInfo *meta_info = NULL;
+
+  if (g_once_init_enter (&meta_info)) {
+    const GstMetaInfo *mi = gst_meta_register (GST_UNIX_LATENCY_META_API_TYPE,
+        "GstUNIXLatencyMeta",
+        sizeof (GstUNIXLatencyMeta),
+        gst_unix_latency_meta_init,
+        (GstMetaFreeFunction) NULL,
+        gst_unix_latency_meta_transform);
+    g_once_init_leave (&meta_info, mi);
+  }
+  return meta_info;
+}
+
+GstUNIXLatencyMeta *
+gst_buffer_add_unix_latency_meta (GstBuffer * buffer, GstClockTime send_time,
+    GstClockTime latency)
+{
+  GstUNIXLatencyMeta *meta;
+
+  meta = (GstUNIXLatencyMeta *) gst_buffer_add_meta (buffer,
+      GST_UNIX_LATENCY_META_INFO, NULL);
+  meta->send_time = send_time;
+  meta->latency = latency;
+
+  return meta;
+}
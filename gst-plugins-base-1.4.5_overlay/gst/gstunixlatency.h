@@ -0,0 +1,92 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_LATENCY_H__
+#define __GST_UNIX_LATENCY_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* sub-buckets per power of two, gives a relative error below 1/16 */
+#define GST_UNIX_HISTOGRAM_SUB_BITS     4
+#define GST_UNIX_HISTOGRAM_SUB_BUCKETS  (1 << GST_UNIX_HISTOGRAM_SUB_BITS)
+#define GST_UNIX_HISTOGRAM_BUCKETS      (64 * GST_UNIX_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct _GstUNIXHistogram GstUNIXHistogram;
+typedef struct _GstUNIXLatencyMeta GstUNIXLatencyMeta;
+
+/**
+ * GstUNIXHistogram:
+ *
+ * Log-linear histogram of nanosecond values, in the spirit of HDR
+ * histograms: constant relative precision over the whole range with a
+ * fixed amount of memory and O(1) recording.
+ */
+struct _GstUNIXHistogram {
+  guint64 count;
+  guint64 total;
+  guint64 min;
+  guint64 max;
+  guint64 buckets[GST_UNIX_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * GstUNIXLatencyMeta:
+ * @meta: parent #GstMeta
+ * @send_time: CLOCK_MONOTONIC time at which unixserversink got the buffer
+ * @latency: time the buffer spent in transport until unixclientsrc pushed it
+ *
+ * Transport latency of a buffer received over a UNIX socket.
+ */
+struct _GstUNIXLatencyMeta {
+  GstMeta meta;
+
+  GstClockTime send_time;
+  GstClockTime latency;
+};
+
+GType        gst_unix_latency_meta_api_get_type (void);
+#define GST_UNIX_LATENCY_META_API_TYPE (gst_unix_latency_meta_api_get_type())
+
+const GstMetaInfo *gst_unix_latency_meta_get_info (void);
+#define GST_UNIX_LATENCY_META_INFO (gst_unix_latency_meta_get_info())
+
+#define gst_buffer_get_unix_latency_meta(b) \
+  ((GstUNIXLatencyMeta*)gst_buffer_get_meta((b),GST_UNIX_LATENCY_META_API_TYPE))
+
+GstUNIXLatencyMeta *gst_buffer_add_unix_latency_meta (GstBuffer * buffer,
+                                                      GstClockTime send_time,
+                                                      GstClockTime latency);
+
+GstClockTime gst_unix_latency_now             (void);
+
+void         gst_unix_histogram_reset         (GstUNIXHistogram * hist);
+void         gst_unix_histogram_record        (GstUNIXHistogram * hist,
+                                               guint64 value);
+guint64      gst_unix_histogram_percentile    (const GstUNIXHistogram * hist,
+                                               gdouble percentile);
+void         gst_unix_histogram_add_to_structure (const GstUNIXHistogram * hist,
+                                               GstStructure * s,
+                                               const gchar * prefix);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_LATENCY_H__ */
@@ -0,0 +1,370 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* In-process fast path. Every unixserversink registers its path in a
+ * process-wide registry; a unixclientsrc finding its path there subscribes
+ * a channel and gets buffer references handed over through a GstAtomicQueue
+ * instead of bytes through the kernel.
+ *
+ * The registry lock only guards the path to server table and is taken to
+ * look up, subscribe and unsubscribe, never per buffer. Each server has its
+ * own lock for its channel list, so pushing only contends with clients of
+ * the same server coming and going. The consumer only takes the channel
+ * lock when the queue ran empty and it has to sleep; the producer only takes
+ * it to wake a sleeping consumer.
+ *
+ * Locks are taken in the order registry, server, channel. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gstatomicqueue.h>
+
+#include "gstunixlocal.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+struct _GstUNIXLocalServer
+{
+  gchar *key;
+
+  GMutex lock;
+  GList *channels;              /* protected by lock */
+  gint64 max_buffers;           /* protected by lock */
+  gint64 max_bytes;             /* protected by lock */
+};
+
+struct _GstUNIXLocalChannel
+{
+  volatile gint refcount;
+  /* written with the server lock, freed with the registry lock */
+  GstUNIXLocalServer *server;
+
+  GstAtomicQueue *queue;
+  volatile gsize bytes;         /* queued */
+  volatile gint waiting;
+  volatile gint flushing;
+
+  GMutex lock;
+  GCond cond;
+  gboolean eos;
+  gboolean closed;
+};
+
+G_LOCK_DEFINE_STATIC (registry);
+static GHashTable *registry = NULL;
+
+static gchar *
+gst_unix_local_key (const gchar * path)
+{
+  gchar *cwd, *key;
+
+  if (g_path_is_absolute (path))
+    return g_strdup (path);
+
+  cwd = g_get_current_dir ();
+  key = g_build_filename (cwd, path, NULL);
+  g_free (cwd);
+
+  return key;
+}
+
+GstUNIXLocalChannel *
+gst_unix_local_channel_ref (GstUNIXLocalChannel * channel)
+{
+  g_atomic_int_inc (&channel->refcount);
+
+  return channel;
+}
+
+void
+gst_unix_local_channel_unref (GstUNIXLocalChannel * channel)
+{
+  GstBuffer *buf;
+
+  if (!g_atomic_int_dec_and_test (&channel->refcount))
+    return;
+
+  while ((buf = gst_atomic_queue_pop (channel->queue)))
+    gst_buffer_unref (buf);
+  gst_atomic_queue_unref (channel->queue);
+  g_mutex_clear (&channel->lock);
+  g_cond_clear (&channel->cond);
+  g_slice_free (GstUNIXLocalChannel, channel);
+}
+
+/* wake up a consumer sleeping in _pop() */
+static inline void
+gst_unix_local_channel_wake (GstUNIXLocalChannel * channel)
+{
+  if (g_atomic_int_get (&channel->waiting)) {
+    g_mutex_lock (&channel->lock);
+    g_cond_signal (&channel->cond);
+    g_mutex_unlock (&channel->lock);
+  }
+}
+
+/* called with the server lock, drops the server's reference */
+static void
+gst_unix_local_channel_disconnect (GstUNIXLocalChannel * channel)
+{
+  GstUNIXLocalServer *server = channel->server;
+
+  server->channels = g_list_remove (server->channels, channel);
+  g_atomic_pointer_set (&channel->server, NULL);
+
+  g_mutex_lock (&channel->lock);
+  channel->closed = TRUE;
+  g_cond_signal (&channel->cond);
+  g_mutex_unlock (&channel->lock);
+
+  gst_unix_local_channel_unref (channel);
+}
+
+/* register a server for @path. Returns NULL when another element of this
+ * process already serves it */
+GstUNIXLocalServer *
+gst_unix_local_server_new (const gchar * path)
+{
+  GstUNIXLocalServer *server;
+  gchar *key;
+
+  key = gst_unix_local_key (path);
+
+  G_LOCK (registry);
+  if (!registry)
+    registry = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (g_hash_table_contains (registry, key)) {
+    G_UNLOCK (registry);
+    GST_WARNING ("%s already served in this process", key);
+    g_free (key);
+    return NULL;
+  }
+
+  server = g_slice_new0 (GstUNIXLocalServer);
+  server->key = key;
+  server->max_buffers = GST_UNIX_LOCAL_QUEUE_MAX;
+  server->max_bytes = GST_UNIX_LOCAL_BYTES_MAX;
+  g_mutex_init (&server->lock);
+  g_hash_table_insert (registry, server->key, server);
+  G_UNLOCK (registry);
+
+  GST_DEBUG ("registered local server for %s", key);
+
+  return server;
+}
+
+/* unregister @server, its clients see EOS once they drained their queue */
+void
+gst_unix_local_server_free (GstUNIXLocalServer * server)
+{
+  /* keep the registry lock until the server is gone, _channel_close()
+   * relies on it to dereference channel->server */
+  G_LOCK (registry);
+  g_hash_table_remove (registry, server->key);
+  g_mutex_lock (&server->lock);
+  while (server->channels)
+    gst_unix_local_channel_disconnect (server->channels->data);
+  g_mutex_unlock (&server->lock);
+  G_UNLOCK (registry);
+
+  GST_DEBUG ("unregistered local server for %s", server->key);
+
+  g_mutex_clear (&server->lock);
+  g_free (server->key);
+  g_slice_free (GstUNIXLocalServer, server);
+}
+
+/* limit how many buffers and bytes a client may lag behind, -1 for the
+ * defaults */
+void
+gst_unix_local_server_set_limits (GstUNIXLocalServer * server,
+    gint64 max_buffers, gint64 max_bytes)
+{
+  g_mutex_lock (&server->lock);
+  server->max_buffers = max_buffers > 0 ? max_buffers :
+      GST_UNIX_LOCAL_QUEUE_MAX;
+  server->max_bytes = max_bytes > 0 ? max_bytes : GST_UNIX_LOCAL_BYTES_MAX;
+  g_mutex_unlock (&server->lock);
+
+  GST_DEBUG ("local clients of %s may lag %" G_GINT64_FORMAT " buffers, %"
+      G_GINT64_FORMAT " bytes", server->key, server->max_buffers,
+      server->max_bytes);
+}
+
+/* hand a reference to @buffer to every local client. Clients lagging more
+ * than the limits behind are disconnected */
+void
+gst_unix_local_server_push (GstUNIXLocalServer * server, GstBuffer * buffer)
+{
+  GList *walk, *next;
+  gsize size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&server->lock);
+  for (walk = server->channels; walk; walk = next) {
+    GstUNIXLocalChannel *channel = walk->data;
+
+    next = walk->next;
+
+    if (gst_atomic_queue_length (channel->queue) >= server->max_buffers ||
+        (gsize) g_atomic_pointer_get (&channel->bytes) + size >
+        (guint64) server->max_bytes) {
+      GST_WARNING ("local client %p of %s lagging, disconnecting", channel,
+          server->key);
+      gst_unix_local_channel_disconnect (channel);
+      continue;
+    }
+
+    g_atomic_pointer_add (&channel->bytes, size);
+    gst_atomic_queue_push (channel->queue, gst_buffer_ref (buffer));
+    gst_unix_local_channel_wake (channel);
+  }
+  g_mutex_unlock (&server->lock);
+}
+
+void
+gst_unix_local_server_set_eos (GstUNIXLocalServer * server, gboolean eos)
+{
+  GList *walk;
+
+  g_mutex_lock (&server->lock);
+  for (walk = server->channels; walk; walk = walk->next) {
+    GstUNIXLocalChannel *channel = walk->data;
+
+    g_mutex_lock (&channel->lock);
+    channel->eos = eos;
+    g_cond_signal (&channel->cond);
+    g_mutex_unlock (&channel->lock);
+  }
+  g_mutex_unlock (&server->lock);
+}
+
+/* subscribe to the server of @path in this process, NULL if there is none */
+GstUNIXLocalChannel *
+gst_unix_local_connect (const gchar * path)
+{
+  GstUNIXLocalServer *server = NULL;
+  GstUNIXLocalChannel *channel = NULL;
+  gchar *key;
+
+  key = gst_unix_local_key (path);
+
+  G_LOCK (registry);
+  if (registry)
+    server = g_hash_table_lookup (registry, key);
+  if (server) {
+    channel = g_slice_new0 (GstUNIXLocalChannel);
+    /* one for the server, one for the caller */
+    channel->refcount = 2;
+    channel->server = server;
+    channel->queue = gst_atomic_queue_new (32);
+    g_mutex_init (&channel->lock);
+    g_cond_init (&channel->cond);
+    g_mutex_lock (&server->lock);
+    server->channels = g_list_append (server->channels, channel);
+    g_mutex_unlock (&server->lock);
+  }
+  G_UNLOCK (registry);
+
+  if (channel)
+    GST_DEBUG ("local client %p connected to %s", channel, key);
+  g_free (key);
+
+  return channel;
+}
+
+/* unsubscribe and drop the reference returned by _connect() */
+void
+gst_unix_local_channel_close (GstUNIXLocalChannel * channel)
+{
+  GstUNIXLocalServer *server;
+
+  /* the registry lock keeps the server alive, its lock keeps a lagging
+   * push from disconnecting us at the same time */
+  G_LOCK (registry);
+  server = g_atomic_pointer_get (&channel->server);
+  if (server) {
+    g_mutex_lock (&server->lock);
+    if (channel->server)
+      gst_unix_local_channel_disconnect (channel);
+    g_mutex_unlock (&server->lock);
+  }
+  G_UNLOCK (registry);
+
+  gst_unix_local_channel_unref (channel);
+}
+
+/* get the next buffer, blocking until there is one. Returns GST_FLOW_EOS
+ * once the server sent EOS or went away and the queue is drained */
+GstFlowReturn
+gst_unix_local_channel_pop (GstUNIXLocalChannel * channel,
+    GstBuffer ** buffer)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (TRUE) {
+    gboolean done;
+
+    if (G_UNLIKELY (g_atomic_int_get (&channel->flushing)))
+      return GST_FLOW_FLUSHING;
+
+    if ((*buffer = gst_atomic_queue_pop (channel->queue))) {
+      g_atomic_pointer_add (&channel->bytes,
+          -(gssize) gst_buffer_get_size (*buffer));
+      return GST_FLOW_OK;
+    }
+
+    g_mutex_lock (&channel->lock);
+    g_atomic_int_set (&channel->waiting, 1);
+    while (TRUE) {
+      if (g_atomic_int_get (&channel->flushing)) {
+        ret = GST_FLOW_FLUSHING;
+        break;
+      }
+      /* read before the queue length, everything pushed before EOS or the
+       * disconnect is visible then */
+      done = channel->eos || channel->closed;
+      if (gst_atomic_queue_length (channel->queue) > 0)
+        break;
+      if (done) {
+        ret = GST_FLOW_EOS;
+        break;
+      }
+      g_cond_wait (&channel->cond, &channel->lock);
+    }
+    g_atomic_int_set (&channel->waiting, 0);
+    g_mutex_unlock (&channel->lock);
+
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+}
+
+void
+gst_unix_local_channel_set_flushing (GstUNIXLocalChannel * channel,
+    gboolean flushing)
+{
+  g_mutex_lock (&channel->lock);
+  g_atomic_int_set (&channel->flushing, flushing);
+  g_cond_signal (&channel->cond);
+  g_mutex_unlock (&channel->lock);
+}
@@ -0,0 +1,59 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_LOCAL_H__
+#define __GST_UNIX_LOCAL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* how far a local client may lag behind before it is disconnected, unless
+ * the sink sets its own limits */
+#define GST_UNIX_LOCAL_QUEUE_MAX        512
+#define GST_UNIX_LOCAL_BYTES_MAX        (256 * 1024 * 1024)
+
+typedef struct _GstUNIXLocalServer GstUNIXLocalServer;
+typedef struct _GstUNIXLocalChannel GstUNIXLocalChannel;
+
+/* server side, used by unixserversink */
+GstUNIXLocalServer  *gst_unix_local_server_new       (const gchar * path);
+void                 gst_unix_local_server_free      (GstUNIXLocalServer * server);
+void                 gst_unix_local_server_set_limits (GstUNIXLocalServer * server,
+                                                      gint64 max_buffers,
+                                                      gint64 max_bytes);
+void                 gst_unix_local_server_push      (GstUNIXLocalServer * server,
+                                                      GstBuffer * buffer);
+void                 gst_unix_local_server_set_eos   (GstUNIXLocalServer * server,
+                                                      gboolean eos);
+
+/* client side, used by unixclientsrc */
+GstUNIXLocalChannel *gst_unix_local_connect          (const gchar * path);
+void                 gst_unix_local_channel_close    (GstUNIXLocalChannel * channel);
+GstUNIXLocalChannel *gst_unix_local_channel_ref      (GstUNIXLocalChannel * channel);
+void                 gst_unix_local_channel_unref    (GstUNIXLocalChannel * channel);
+GstFlowReturn        gst_unix_local_channel_pop      (GstUNIXLocalChannel * channel,
+                                                      GstBuffer ** buffer);
+void                 gst_unix_local_channel_set_flushing (GstUNIXLocalChannel * channel,
+                                                      gboolean flushing);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_LOCAL_H__ */
@@ -0,0 +1,301 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Framed wire protocol shared by unixserversink and unixclientsrc.
+ *
+ * A framed client starts by sending a HELLO message whose payload is a
+ * serialized, NUL terminated #GstStructure describing what it wants from
+ * the server. After that the server sends one BUFFER message per buffer
+ * (or per stripe of a buffer), each consisting of a #GstUNIXFrameHeader
+ * followed by @size bytes of payload.
+ *
+ * A client that asked for a rendition gets a CAPS message, a serialized NUL
+ * terminated #GstCaps, before the first buffer and whenever the format of
+ * the converted stream changes.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstunixprotocol.h"
+#include "gstunixclientwire.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+G_STATIC_ASSERT (sizeof (GstUNIXFrameHeader) == 64);
+
+/* the standalone client library has its own copy of the wire format */
+G_STATIC_ASSERT (sizeof (GstUNIXFrameHeader) == GST_UNIX_CLIENT_HEADER_SIZE);
+G_STATIC_ASSERT (GST_UNIX_PROTOCOL_MAGIC == GST_UNIX_CLIENT_MAGIC);
+G_STATIC_ASSERT (GST_UNIX_PROTOCOL_VERSION == GST_UNIX_CLIENT_VERSION);
+G_STATIC_ASSERT (GST_UNIX_PROTOCOL_MAX_HELLO == GST_UNIX_CLIENT_MAX_CAPS);
+G_STATIC_ASSERT (GST_UNIX_FRAME_FLAG_DISCONT == GST_UNIX_CLIENT_FLAG_DISCONT);
+G_STATIC_ASSERT (GST_UNIX_FRAME_FLAG_DELTA_UNIT ==
+    GST_UNIX_CLIENT_FLAG_DELTA_UNIT);
+G_STATIC_ASSERT (GST_UNIX_FRAME_FLAG_HEADER == GST_UNIX_CLIENT_FLAG_HEADER);
+G_STATIC_ASSERT (GST_UNIX_MESSAGE_HELLO == GST_UNIX_CLIENT_MESSAGE_HELLO);
+G_STATIC_ASSERT (GST_UNIX_MESSAGE_BUFFER == GST_UNIX_CLIENT_MESSAGE_BUFFER);
+G_STATIC_ASSERT (GST_UNIX_MESSAGE_CAPS == GST_UNIX_CLIENT_MESSAGE_CAPS);
+
+#define GST_UNIX_ASSERT_SAME_OFFSET(field) \
+  G_STATIC_ASSERT (G_STRUCT_OFFSET (GstUNIXFrameHeader, field) == \
+      G_STRUCT_OFFSET (GstUNIXClientHeader, field))
+
+G_STATIC_ASSERT (sizeof (GstUNIXClientHeader) == GST_UNIX_CLIENT_HEADER_SIZE);
+GST_UNIX_ASSERT_SAME_OFFSET (magic);
+GST_UNIX_ASSERT_SAME_OFFSET (version);
+GST_UNIX_ASSERT_SAME_OFFSET (type);
+GST_UNIX_ASSERT_SAME_OFFSET (flags);
+GST_UNIX_ASSERT_SAME_OFFSET (size);
+GST_UNIX_ASSERT_SAME_OFFSET (seq);
+GST_UNIX_ASSERT_SAME_OFFSET (offset);
+GST_UNIX_ASSERT_SAME_OFFSET (total_size);
+GST_UNIX_ASSERT_SAME_OFFSET (pts);
+GST_UNIX_ASSERT_SAME_OFFSET (duration);
+GST_UNIX_ASSERT_SAME_OFFSET (send_time);
+
+GType
+gst_unix_protocol_get_type (void)
+{
+  static GType unix_protocol_type = 0;
+  static const GEnumValue unix_protocol[] = {
+    {GST_UNIX_PROTOCOL_RAW, "Plain byte stream", "raw"},
+    {GST_UNIX_PROTOCOL_FRAMED, "Framed buffers with handshake", "framed"},
+    {0, NULL, NULL},
+  };
+
+  if (!unix_protocol_type) {
+    unix_protocol_type =
+        g_enum_register_static ("GstUNIXProtocol", unix_protocol);
+  }
+  return unix_protocol_type;
+}
+
+void
+gst_unix_frame_header_init (GstUNIXFrameHeader * header,
+    GstUNIXMessageType type, gsize size)
+{
+  memset (header, 0, sizeof (GstUNIXFrameHeader));
+  header->magic = GST_UNIX_PROTOCOL_MAGIC;
+  header->version = GST_UNIX_PROTOCOL_VERSION;
+  header->type = type;
+  header->size = size;
+  header->total_size = size;
+  header->pts = GST_CLOCK_TIME_NONE;
+  header->duration = GST_CLOCK_TIME_NONE;
+}
+
+gboolean
+gst_unix_frame_header_is_valid (const GstUNIXFrameHeader * header)
+{
+  return header->magic == GST_UNIX_PROTOCOL_MAGIC &&
+      header->version == GST_UNIX_PROTOCOL_VERSION &&
+      header->offset + header->size <= header->total_size;
+}
+
+/* read exactly @size bytes. Returns GST_FLOW_EOS when the peer closed the
+ * connection before the first byte, GST_FLOW_FLUSHING when @cancellable was
+ * triggered and GST_FLOW_ERROR with @error set otherwise */
+GstFlowReturn
+gst_unix_socket_receive_all (GSocket * socket, gpointer data, gsize size,
+    GCancellable * cancellable, GError ** error)
+{
+  gchar *ptr = data;
+  gsize done = 0;
+
+  while (done < size) {
+    GError *err = NULL;
+    gssize rret;
+
+    rret = g_socket_receive (socket, ptr + done, size - done, cancellable,
+        &err);
+    if (rret < 0) {
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_clear_error (&err);
+        return GST_FLOW_FLUSHING;
+      }
+      g_propagate_error (error, err);
+      return GST_FLOW_ERROR;
+    } else if (rret == 0) {
+      if (done == 0)
+        return GST_FLOW_EOS;
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Connection closed after %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT
+          " bytes", done, size);
+      return GST_FLOW_ERROR;
+    }
+    done += rret;
+  }
+
+  return GST_FLOW_OK;
+}
+
+/* write all @vectors, retrying on short writes */
+gboolean
+gst_unix_socket_send_all (GSocket * socket, GOutputVector * vectors,
+    gint num_vectors, GCancellable * cancellable, GError ** error)
+{
+  while (num_vectors > 0) {
+    gssize sret;
+
+    sret = g_socket_send_message (socket, NULL, vectors, num_vectors, NULL, 0,
+        0, cancellable, error);
+    if (sret < 0)
+      return FALSE;
+
+    /* skip what was written */
+    while (num_vectors > 0 && (gsize) sret >= vectors->size) {
+      sret -= vectors->size;
+      vectors++;
+      num_vectors--;
+    }
+    if (num_vectors > 0) {
+      vectors->buffer = (const gchar *) vectors->buffer + sret;
+      vectors->size -= sret;
+    }
+  }
+
+  return TRUE;
+}
+
+gboolean
+gst_unix_protocol_send_hello (GSocket * socket, const GstStructure * hello,
+    GCancellable * cancellable, GError ** error)
+{
+  GstUNIXFrameHeader header;
+  GOutputVector vectors[2];
+  gchar *str;
+  gboolean ret;
+
+  str = gst_structure_to_string (hello);
+
+  gst_unix_frame_header_init (&header, GST_UNIX_MESSAGE_HELLO,
+      strlen (str) + 1);
+
+  vectors[0].buffer = &header;
+  vectors[0].size = sizeof (header);
+  vectors[1].buffer = str;
+  vectors[1].size = header.size;
+
+  GST_DEBUG ("sending hello %s", str);
+  ret = gst_unix_socket_send_all (socket, vectors, 2, cancellable, error);
+  g_free (str);
+
+  return ret;
+}
+
+gboolean
+gst_unix_protocol_send_caps (GSocket * socket, const GstCaps * caps,
+    GCancellable * cancellable, GError ** error)
+{
+  GstUNIXFrameHeader header;
+  GOutputVector vectors[2];
+  gchar *str;
+  gboolean ret;
+
+  str = gst_caps_to_string (caps);
+
+  gst_unix_frame_header_init (&header, GST_UNIX_MESSAGE_CAPS,
+      strlen (str) + 1);
+
+  vectors[0].buffer = &header;
+  vectors[0].size = sizeof (header);
+  vectors[1].buffer = str;
+  vectors[1].size = header.size;
+
+  GST_DEBUG ("sending caps %s", str);
+  ret = gst_unix_socket_send_all (socket, vectors, 2, cancellable, error);
+  g_free (str);
+
+  return ret;
+}
+
+/* check that @header announces a hello we are willing to read */
+gboolean
+gst_unix_protocol_check_hello (const GstUNIXFrameHeader * header,
+    GError ** error)
+{
+  if (!gst_unix_frame_header_is_valid (header) ||
+      header->type != GST_UNIX_MESSAGE_HELLO || header->size == 0 ||
+      header->size > GST_UNIX_PROTOCOL_MAX_HELLO) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "Invalid hello message");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* parse the @size bytes of hello payload in @str, which is modified */
+GstStructure *
+gst_unix_protocol_parse_hello (gchar * str, gsize size, GError ** error)
+{
+  GstStructure *hello;
+
+  str[size - 1] = '\0';
+
+  GST_DEBUG ("received hello %s", str);
+  hello = gst_structure_from_string (str, NULL);
+  if (!hello)
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "Invalid hello message");
+
+  return hello;
+}
+
+GstStructure *
+gst_unix_protocol_receive_hello (GSocket * socket, GCancellable * cancellable,
+    GError ** error)
+{
+  GstUNIXFrameHeader header;
+  GstStructure *hello;
+  gchar *str;
+
+  if (gst_unix_socket_receive_all (socket, &header, sizeof (header),
+          cancellable, error) != GST_FLOW_OK)
+    goto read_failed;
+
+  if (!gst_unix_protocol_check_hello (&header, error))
+    return NULL;
+
+  str = g_malloc (header.size);
+  if (gst_unix_socket_receive_all (socket, str, header.size, cancellable,
+          error) != GST_FLOW_OK) {
+    g_free (str);
+    goto read_failed;
+  }
+
+  hello = gst_unix_protocol_parse_hello (str, header.size, error);
+  g_free (str);
+
+  return hello;
+
+  /* ERRORS */
+read_failed:
+  {
+    if (error && !*error)
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Connection closed during handshake");
+    return NULL;
+  }
+}
@@ -0,0 +1,136 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_PROTOCOL_H__
+#define __GST_UNIX_PROTOCOL_H__
+
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* "GSTU" in host byte order; both ends always live on the same host, so
+ * the framed protocol never swaps bytes */
+#define GST_UNIX_PROTOCOL_MAGIC         0x55545347
+#define GST_UNIX_PROTOCOL_VERSION       1
+
+/* upper bound for the serialized hello structure and caps */
+#define GST_UNIX_PROTOCOL_MAX_HELLO     4096
+
+/* upper bound for the stripes a client may request */
+#define GST_UNIX_PROTOCOL_MAX_STRIPES   64
+
+#define GST_TYPE_UNIX_PROTOCOL (gst_unix_protocol_get_type())
+
+/**
+ * GstUNIXProtocol:
+ * @GST_UNIX_PROTOCOL_RAW: plain byte stream, no handshake (default)
+ * @GST_UNIX_PROTOCOL_FRAMED: every client sends a hello, every buffer is
+ *   preceded by a #GstUNIXFrameHeader
+ *
+ * Wire protocol spoken between unixserversink and unixclientsrc.
+ */
+typedef enum {
+  GST_UNIX_PROTOCOL_RAW,
+  GST_UNIX_PROTOCOL_FRAMED
+} GstUNIXProtocol;
+
+typedef enum {
+  GST_UNIX_MESSAGE_HELLO  = 1,
+  GST_UNIX_MESSAGE_BUFFER = 2,
+  GST_UNIX_MESSAGE_CAPS   = 3
+} GstUNIXMessageType;
+
+typedef enum {
+  GST_UNIX_FRAME_FLAG_DISCONT     = (1 << 0),
+  GST_UNIX_FRAME_FLAG_DELTA_UNIT  = (1 << 1),
+  GST_UNIX_FRAME_FLAG_HEADER      = (1 << 2)
+} GstUNIXFrameFlags;
+
+typedef struct _GstUNIXFrameHeader GstUNIXFrameHeader;
+
+/**
+ * GstUNIXFrameHeader:
+ * @magic: #GST_UNIX_PROTOCOL_MAGIC
+ * @version: #GST_UNIX_PROTOCOL_VERSION
+ * @type: a #GstUNIXMessageType
+ * @flags: #GstUNIXFrameFlags
+ * @size: number of payload bytes following the header
+ * @seq: buffer sequence number, shared by all stripes of one buffer
+ * @offset: offset of the payload inside the original buffer
+ * @total_size: size of the original buffer
+ * @pts: presentation timestamp of the original buffer
+ * @duration: duration of the original buffer
+ * @send_time: CLOCK_MONOTONIC time in nanoseconds at which the server got
+ *   the buffer, 0 when not stamped
+ *
+ * Fixed size header preceding every message in framed mode.
+ */
+struct _GstUNIXFrameHeader {
+  guint32 magic;
+  guint16 version;
+  guint16 type;
+  guint32 flags;
+  guint32 size;
+  guint64 seq;
+  guint64 offset;
+  guint64 total_size;
+  guint64 pts;
+  guint64 duration;
+  guint64 send_time;
+};
+
+GType         gst_unix_protocol_get_type      (void);
+
+void          gst_unix_frame_header_init      (GstUNIXFrameHeader * header,
+                                               GstUNIXMessageType type,
+                                               gsize size);
+gboolean      gst_unix_frame_header_is_valid  (const GstUNIXFrameHeader * header);
+
+GstFlowReturn gst_unix_socket_receive_all     (GSocket * socket, gpointer data,
+                                               gsize size,
+                                               GCancellable * cancellable,
+                                               GError ** error);
+gboolean      gst_unix_socket_send_all        (GSocket * socket,
+                                               GOutputVector * vectors,
+                                               gint num_vectors,
+                                               GCancellable * cancellable,
+                                               GError ** error);
+
+gboolean      gst_unix_protocol_send_hello    (GSocket * socket,
+                                               const GstStructure * hello,
+                                               GCancellable * cancellable,
+                                               GError ** error);
+GstStructure *gst_unix_protocol_receive_hello (GSocket * socket,
+                                               GCancellable * cancellable,
+                                               GError ** error);
+gboolean      gst_unix_protocol_check_hello   (const GstUNIXFrameHeader * header,
+                                               GError ** error);
+GstStructure *gst_unix_protocol_parse_hello   (gchar * str, gsize size,
+                                               GError ** error);
+
+gboolean      gst_unix_protocol_send_caps     (GSocket * socket,
+                                               const GstCaps * caps,
+                                               GCancellable * cancellable,
+                                               GError ** error);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_PROTOCOL_H__ */
@@ -0,0 +1,505 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Server side renditions. Framed clients may ask for the stream in another
+ * format (rate, channels, sample format) in their hello. All clients asking
+ * for the same caps share one rendition: a bin of audioconvert !
+ * audioresample ! capsfilter fed from the render thread of unixserversink,
+ * so the conversion is done once per distinct format. The converted buffers
+ * are framed and written to the subscribers by a writer thread per
+ * rendition, slow subscribers only hold up their own rendition and are
+ * dropped after GST_UNIX_RENDITION_SEND_TIMEOUT. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstunixrendition.h"
+#include "gstunixprotocol.h"
+#include "gstunixtrace.h"
+#include "gstunixsockbuf.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+typedef struct
+{
+  GSocket *socket;
+  GstCaps *caps;                /* last caps sent to the client */
+} GstUNIXRenditionClient;
+
+typedef struct
+{
+  GstBuffer *buffer;
+  GstCaps *caps;
+  guint64 seq;
+  GstClockTime send_time;
+  gboolean discont;             /* jobs before this one were dropped */
+} GstUNIXRenditionJob;
+
+struct _GstUNIXRendition
+{
+  GstObject *parent;
+  GstCaps *caps;                /* requested */
+
+  /* conversion, only used from the render thread */
+  GstElement *bin;
+  GstPad *srcpad;
+  GstPad *sinkpad;
+  GstCaps *in_caps;
+  GstCaps *out_caps;
+  gboolean started;
+  guint64 seq;
+  GstClockTime send_time;
+
+  /* writer thread */
+  GMutex lock;
+  GCond cond;
+  GList *clients;               /* protected by lock */
+  GQueue queue;                 /* GstUNIXRenditionJob, protected by lock */
+  gboolean running;
+  guint64 dropped;              /* protected by lock */
+  GCancellable *cancellable;
+  GThread *thread;
+
+  /* send buffer sizing, protected by lock */
+  GstClockTime latency_target;
+  GstUNIXBitrate bitrate;
+  gint sndbuf;
+  gint sndbuf_applied;          /* granted by the kernel */
+};
+
+static void
+gst_unix_rendition_job_free (GstUNIXRenditionJob * job)
+{
+  gst_buffer_unref (job->buffer);
+  gst_caps_unref (job->caps);
+  g_slice_free (GstUNIXRenditionJob, job);
+}
+
+static void
+gst_unix_rendition_client_free (GstUNIXRenditionClient * client)
+{
+  g_socket_close (client->socket, NULL);
+  g_object_unref (client->socket);
+  if (client->caps)
+    gst_caps_unref (client->caps);
+  g_slice_free (GstUNIXRenditionClient, client);
+}
+
+static gboolean
+gst_unix_rendition_send (GstUNIXRendition * rendition,
+    GstUNIXRenditionClient * client, GstUNIXRenditionJob * job,
+    GError ** err)
+{
+  GstUNIXFrameHeader header;
+  GOutputVector vectors[2];
+  GstMapInfo map;
+  gboolean ret;
+
+  if (client->caps != job->caps) {
+    if (!gst_unix_protocol_send_caps (client->socket, job->caps,
+            rendition->cancellable, err))
+      return FALSE;
+    gst_caps_replace (&client->caps, job->caps);
+  }
+
+  gst_buffer_map (job->buffer, &map, GST_MAP_READ);
+  gst_unix_frame_header_init (&header, GST_UNIX_MESSAGE_BUFFER, map.size);
+  header.seq = job->seq;
+  header.send_time = job->send_time;
+  header.pts = GST_BUFFER_PTS (job->buffer);
+  header.duration = GST_BUFFER_DURATION (job->buffer);
+  if (job->discont ||
+      GST_BUFFER_FLAG_IS_SET (job->buffer, GST_BUFFER_FLAG_DISCONT))
+    header.flags |= GST_UNIX_FRAME_FLAG_DISCONT;
+
+  vectors[0].buffer = &header;
+  vectors[0].size = sizeof (header);
+  vectors[1].buffer = map.data;
+  vectors[1].size = map.size;
+
+  ret = gst_unix_socket_send_all (client->socket, vectors, 2,
+      rendition->cancellable, err);
+  gst_buffer_unmap (job->buffer, &map);
+
+  return ret;
+}
+
+/* size the send buffers of the clients for the converted bitrate, called
+ * with the lock */
+static void
+gst_unix_rendition_resize (GstUNIXRendition * rendition)
+{
+  GList *walk;
+  gint size;
+
+  size = gst_unix_sockbuf_size_for (rendition->bitrate.rate,
+      rendition->latency_target);
+  if (!gst_unix_sockbuf_differs (rendition->sndbuf, size))
+    return;
+  rendition->sndbuf = size;
+
+  GST_DEBUG_OBJECT (rendition->parent, "rendition %" GST_PTR_FORMAT
+      " send buffers now %d bytes", rendition->caps, size);
+
+  for (walk = rendition->clients; walk; walk = walk->next) {
+    GstUNIXRenditionClient *client = walk->data;
+    gint applied;
+
+    applied = gst_unix_socket_set_buffer_size (client->socket, TRUE, size);
+    if (applied >= 0)
+      rendition->sndbuf_applied = applied;
+  }
+}
+
+static gpointer
+gst_unix_rendition_thread (GstUNIXRendition * rendition)
+{
+  GstUNIXRenditionJob *job;
+  GList *clients, *walk;
+  GError *err = NULL;
+  guint sent;
+  gsize size;
+
+  g_mutex_lock (&rendition->lock);
+  while (TRUE) {
+    while (rendition->running && g_queue_is_empty (&rendition->queue))
+      g_cond_wait (&rendition->cond, &rendition->lock);
+    if (!rendition->running)
+      break;
+
+    job = g_queue_pop_head (&rendition->queue);
+    /* clients are only removed by this thread */
+    clients = g_list_copy (rendition->clients);
+    g_mutex_unlock (&rendition->lock);
+
+    sent = 0;
+    for (walk = clients; walk; walk = walk->next) {
+      GstUNIXRenditionClient *client = walk->data;
+
+      if (gst_unix_rendition_send (rendition, client, job, &err)) {
+        sent++;
+        continue;
+      }
+
+      GST_WARNING_OBJECT (rendition->parent,
+          "dropping rendition client %p: %s", client->socket, err->message);
+      g_clear_error (&err);
+
+      g_mutex_lock (&rendition->lock);
+      rendition->clients = g_list_remove (rendition->clients, client);
+      g_mutex_unlock (&rendition->lock);
+      gst_unix_rendition_client_free (client);
+    }
+    GST_UNIX_TRACE3 (rendition_send, rendition->parent, job->seq, sent);
+    g_list_free (clients);
+    size = gst_buffer_get_size (job->buffer);
+    gst_unix_rendition_job_free (job);
+
+    g_mutex_lock (&rendition->lock);
+    if (gst_unix_bitrate_update (&rendition->bitrate, size) &&
+        rendition->latency_target)
+      gst_unix_rendition_resize (rendition);
+  }
+  g_mutex_unlock (&rendition->lock);
+
+  return NULL;
+}
+
+/* converted buffers arrive here, still in the render thread */
+static GstFlowReturn
+gst_unix_rendition_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstUNIXRendition *rendition = gst_pad_get_element_private (pad);
+  GstUNIXRenditionJob *job;
+
+  if (G_UNLIKELY (!rendition->out_caps)) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  job = g_slice_new (GstUNIXRenditionJob);
+  job->buffer = buf;
+  job->caps = gst_caps_ref (rendition->out_caps);
+  job->seq = rendition->seq++;
+  job->send_time = rendition->send_time;
+  job->discont = FALSE;
+
+  g_mutex_lock (&rendition->lock);
+  g_queue_push_tail (&rendition->queue, job);
+  if (g_queue_get_length (&rendition->queue) > GST_UNIX_RENDITION_QUEUE_MAX) {
+    gst_unix_rendition_job_free (g_queue_pop_head (&rendition->queue));
+    ((GstUNIXRenditionJob *) g_queue_peek_head (&rendition->queue))->discont =
+        TRUE;
+    rendition->dropped++;
+  }
+  g_cond_signal (&rendition->cond);
+  g_mutex_unlock (&rendition->lock);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_unix_rendition_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstUNIXRendition *rendition = gst_pad_get_element_private (pad);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+    GstCaps *caps;
+
+    gst_event_parse_caps (event, &caps);
+    GST_DEBUG_OBJECT (rendition->parent, "rendition %" GST_PTR_FORMAT
+        " negotiated %" GST_PTR_FORMAT, rendition->caps, caps);
+    gst_caps_replace (&rendition->out_caps, caps);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+/* create the rendition producing @caps, NULL when the conversion elements
+ * are missing */
+GstUNIXRendition *
+gst_unix_rendition_new (GstObject * parent, const GstCaps * caps,
+    GError ** error)
+{
+  GstUNIXRendition *rendition;
+  GstElement *convert, *resample, *filter;
+  GstPad *pad;
+
+  convert = gst_element_factory_make ("audioconvert", NULL);
+  resample = gst_element_factory_make ("audioresample", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  if (!convert || !resample || !filter)
+    goto missing_elements;
+
+  rendition = g_slice_new0 (GstUNIXRendition);
+  rendition->parent = parent;
+  rendition->caps = gst_caps_copy (caps);
+
+  rendition->bin = gst_bin_new (NULL);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_bin_add_many (GST_BIN (rendition->bin), convert, resample, filter, NULL);
+  gst_element_link_many (convert, resample, filter, NULL);
+
+  rendition->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  rendition->sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_element_private (rendition->sinkpad, rendition);
+  gst_pad_set_chain_function (rendition->sinkpad, gst_unix_rendition_chain);
+  gst_pad_set_event_function (rendition->sinkpad, gst_unix_rendition_event);
+
+  pad = gst_element_get_static_pad (convert, "sink");
+  gst_pad_link (rendition->srcpad, pad);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (filter, "src");
+  gst_pad_link (pad, rendition->sinkpad);
+  gst_object_unref (pad);
+  gst_pad_set_active (rendition->sinkpad, TRUE);
+  gst_pad_set_active (rendition->srcpad, TRUE);
+  gst_element_set_state (rendition->bin, GST_STATE_PLAYING);
+
+  g_mutex_init (&rendition->lock);
+  g_cond_init (&rendition->cond);
+  g_queue_init (&rendition->queue);
+  gst_unix_bitrate_reset (&rendition->bitrate);
+  rendition->cancellable = g_cancellable_new ();
+  rendition->running = TRUE;
+  rendition->thread = g_thread_new ("unixserversink-rendition",
+      (GThreadFunc) gst_unix_rendition_thread, rendition);
+
+  GST_DEBUG_OBJECT (parent, "created rendition %" GST_PTR_FORMAT, caps);
+
+  return rendition;
+
+  /* ERRORS */
+missing_elements:
+  {
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+        "renditions need audioconvert, audioresample and capsfilter");
+    if (convert)
+      gst_object_unref (convert);
+    if (resample)
+      gst_object_unref (resample);
+    if (filter)
+      gst_object_unref (filter);
+    return NULL;
+  }
+}
+
+/* tear down @rendition, must be called from the render thread or when it
+ * is stopped */
+void
+gst_unix_rendition_free (GstUNIXRendition * rendition)
+{
+  GST_DEBUG_OBJECT (rendition->parent, "freeing rendition %" GST_PTR_FORMAT,
+      rendition->caps);
+
+  g_mutex_lock (&rendition->lock);
+  rendition->running = FALSE;
+  g_cond_signal (&rendition->cond);
+  g_mutex_unlock (&rendition->lock);
+  g_cancellable_cancel (rendition->cancellable);
+  g_thread_join (rendition->thread);
+
+  gst_pad_set_active (rendition->srcpad, FALSE);
+  gst_element_set_state (rendition->bin, GST_STATE_NULL);
+  gst_pad_set_active (rendition->sinkpad, FALSE);
+  gst_object_unref (rendition->srcpad);
+  gst_object_unref (rendition->sinkpad);
+  gst_object_unref (rendition->bin);
+
+  g_list_free_full (rendition->clients,
+      (GDestroyNotify) gst_unix_rendition_client_free);
+  g_queue_foreach (&rendition->queue, (GFunc) gst_unix_rendition_job_free,
+      NULL);
+  g_queue_clear (&rendition->queue);
+  g_object_unref (rendition->cancellable);
+  g_mutex_clear (&rendition->lock);
+  g_cond_clear (&rendition->cond);
+
+  gst_caps_replace (&rendition->in_caps, NULL);
+  gst_caps_replace (&rendition->out_caps, NULL);
+  gst_caps_unref (rendition->caps);
+  g_slice_free (GstUNIXRendition, rendition);
+}
+
+gboolean
+gst_unix_rendition_has_caps (GstUNIXRendition * rendition,
+    const GstCaps * caps)
+{
+  return gst_caps_is_equal (rendition->caps, caps);
+}
+
+/* takes a reference to @socket */
+void
+gst_unix_rendition_add_client (GstUNIXRendition * rendition, GSocket * socket)
+{
+  GstUNIXRenditionClient *client;
+
+  client = g_slice_new0 (GstUNIXRenditionClient);
+  client->socket = g_object_ref (socket);
+  g_socket_set_timeout (socket, GST_UNIX_RENDITION_SEND_TIMEOUT);
+
+  g_mutex_lock (&rendition->lock);
+  if (rendition->sndbuf > 0) {
+    gint applied;
+
+    applied =
+        gst_unix_socket_set_buffer_size (socket, TRUE, rendition->sndbuf);
+    if (applied >= 0)
+      rendition->sndbuf_applied = applied;
+  }
+  rendition->clients = g_list_append (rendition->clients, client);
+  g_mutex_unlock (&rendition->lock);
+}
+
+/* size the send buffers of the clients to hold @latency of the converted
+ * stream, 0 leaves them alone */
+void
+gst_unix_rendition_set_latency_target (GstUNIXRendition * rendition,
+    GstClockTime latency)
+{
+  g_mutex_lock (&rendition->lock);
+  rendition->latency_target = latency;
+  g_mutex_unlock (&rendition->lock);
+}
+
+guint
+gst_unix_rendition_get_n_clients (GstUNIXRendition * rendition)
+{
+  guint n;
+
+  g_mutex_lock (&rendition->lock);
+  n = g_list_length (rendition->clients);
+  g_mutex_unlock (&rendition->lock);
+
+  return n;
+}
+
+/* convert @buffer of format @caps, called from the render thread */
+void
+gst_unix_rendition_push (GstUNIXRendition * rendition, GstCaps * caps,
+    const GstSegment * segment, GstBuffer * buffer, GstClockTime send_time)
+{
+  GstFlowReturn ret;
+
+  if (G_UNLIKELY (!rendition->started)) {
+    gst_pad_push_event (rendition->srcpad,
+        gst_event_new_stream_start ("unixserversink-rendition"));
+    rendition->started = TRUE;
+  }
+  if (G_UNLIKELY (rendition->in_caps != caps)) {
+    gst_pad_push_event (rendition->srcpad, gst_event_new_caps (caps));
+    gst_caps_replace (&rendition->in_caps, caps);
+    gst_pad_push_event (rendition->srcpad, gst_event_new_segment (segment));
+  }
+
+  rendition->send_time = send_time;
+  ret = gst_pad_push (rendition->srcpad, gst_buffer_ref (buffer));
+  if (ret != GST_FLOW_OK)
+    GST_WARNING_OBJECT (rendition->parent, "rendition %" GST_PTR_FORMAT
+        " failed to convert: %s", rendition->caps, gst_flow_get_name (ret));
+}
+
+/* forward a segment, flush or EOS event of the stream, called from the
+ * thread that got it. Takes ownership of @event. Events before the first
+ * buffer are dropped, _push() sends the segment along with the caps */
+void
+gst_unix_rendition_push_event (GstUNIXRendition * rendition,
+    GstEvent * event)
+{
+  if (!rendition->in_caps) {
+    gst_event_unref (event);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (rendition->parent, "rendition %" GST_PTR_FORMAT
+      " forwarding %" GST_PTR_FORMAT, rendition->caps, event);
+  gst_pad_push_event (rendition->srcpad, event);
+}
+
+void
+gst_unix_rendition_add_to_structure (GstUNIXRendition * rendition,
+    GstStructure * s, const gchar * prefix)
+{
+  gchar *name, *str;
+
+  str = gst_caps_to_string (rendition->caps);
+  name = g_strdup_printf ("%s-caps", prefix);
+  gst_structure_set (s, name, G_TYPE_STRING, str, NULL);
+  g_free (name);
+  g_free (str);
+
+  g_mutex_lock (&rendition->lock);
+  name = g_strdup_printf ("%s-clients", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT, g_list_length (rendition->clients),
+      NULL);
+  g_free (name);
+  name = g_strdup_printf ("%s-dropped", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT64, rendition->dropped, NULL);
+  g_free (name);
+  name = g_strdup_printf ("%s-bitrate", prefix);
+  gst_structure_set (s, name, G_TYPE_UINT64, rendition->bitrate.rate, NULL);
+  g_free (name);
+  name = g_strdup_printf ("%s-send-buffer-size", prefix);
+  gst_structure_set (s, name, G_TYPE_INT, rendition->sndbuf_applied, NULL);
+  g_free (name);
+  g_mutex_unlock (&rendition->lock);
+}
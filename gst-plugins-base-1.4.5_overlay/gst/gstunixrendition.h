@@ -0,0 +1,63 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_RENDITION_H__
+#define __GST_UNIX_RENDITION_H__
+
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* converted buffers a rendition may queue for its writer thread before the
+ * oldest ones are dropped */
+#define GST_UNIX_RENDITION_QUEUE_MAX    16
+
+/* seconds a rendition client may block a write before it is dropped */
+#define GST_UNIX_RENDITION_SEND_TIMEOUT 1
+
+typedef struct _GstUNIXRendition GstUNIXRendition;
+
+/* used by unixserversink for framed clients asking for a rendition */
+GstUNIXRendition *gst_unix_rendition_new        (GstObject * parent,
+                                                 const GstCaps * caps,
+                                                 GError ** error);
+void              gst_unix_rendition_free       (GstUNIXRendition * rendition);
+gboolean          gst_unix_rendition_has_caps   (GstUNIXRendition * rendition,
+                                                 const GstCaps * caps);
+void              gst_unix_rendition_add_client (GstUNIXRendition * rendition,
+                                                 GSocket * socket);
+guint             gst_unix_rendition_get_n_clients (GstUNIXRendition * rendition);
+void              gst_unix_rendition_set_latency_target (GstUNIXRendition * rendition,
+                                                 GstClockTime latency);
+void              gst_unix_rendition_push       (GstUNIXRendition * rendition,
+                                                 GstCaps * caps,
+                                                 const GstSegment * segment,
+                                                 GstBuffer * buffer,
+                                                 GstClockTime send_time);
+void              gst_unix_rendition_push_event (GstUNIXRendition * rendition,
+                                                 GstEvent * event);
+void              gst_unix_rendition_add_to_structure (GstUNIXRendition * rendition,
+                                                 GstStructure * s,
+                                                 const gchar * prefix);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_RENDITION_H__ */
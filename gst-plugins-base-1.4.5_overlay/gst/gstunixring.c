@@ -0,0 +1,226 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Bounded single-producer/single-consumer ring of pointers. Each side only
+ * writes its own index, so neither takes a lock while the ring is neither
+ * full nor empty. A side that has to sleep announces it in waiting before
+ * checking the indices once more under the lock; the other side only takes
+ * the lock to wake it when it sees the announcement, like the in-process
+ * channels do. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstunixring.h"
+
+struct _GstUNIXRing
+{
+  gpointer *items;
+  guint size;
+  guint mask;
+
+  volatile gint head;           /* only written by the producer */
+  volatile gint tail;           /* only written by the consumer */
+
+  volatile gint waiting;
+  volatile gint flushing;
+  volatile gint closed;
+
+  GMutex lock;
+  GCond cond;
+};
+
+GType
+gst_unix_ring_overflow_get_type (void)
+{
+  static GType unix_ring_overflow_type = 0;
+  static const GEnumValue unix_ring_overflow[] = {
+    {GST_UNIX_RING_OVERFLOW_BLOCK, "Wait for a free slot", "block"},
+    {GST_UNIX_RING_OVERFLOW_DROP, "Drop what does not fit", "drop"},
+    {0, NULL, NULL},
+  };
+
+  if (!unix_ring_overflow_type) {
+    unix_ring_overflow_type =
+        g_enum_register_static ("GstUNIXRingOverflow", unix_ring_overflow);
+  }
+  return unix_ring_overflow_type;
+}
+
+/* a ring with room for @size items, rounded up to a power of two */
+GstUNIXRing *
+gst_unix_ring_new (guint size)
+{
+  GstUNIXRing *ring;
+
+  g_return_val_if_fail (size > 0 && size <= G_MAXINT / 2, NULL);
+
+  ring = g_slice_new0 (GstUNIXRing);
+  ring->size = 1;
+  while (ring->size < size)
+    ring->size <<= 1;
+  ring->mask = ring->size - 1;
+  ring->items = g_new0 (gpointer, ring->size);
+  g_mutex_init (&ring->lock);
+  g_cond_init (&ring->cond);
+
+  return ring;
+}
+
+void
+gst_unix_ring_free (GstUNIXRing * ring, GDestroyNotify free_func)
+{
+  gst_unix_ring_clear (ring, free_func);
+  g_free (ring->items);
+  g_mutex_clear (&ring->lock);
+  g_cond_clear (&ring->cond);
+  g_slice_free (GstUNIXRing, ring);
+}
+
+/* drop all queued items, only while the producer is stopped */
+void
+gst_unix_ring_clear (GstUNIXRing * ring, GDestroyNotify free_func)
+{
+  guint head = g_atomic_int_get (&ring->head);
+  guint tail = g_atomic_int_get (&ring->tail);
+
+  for (; tail != head; tail++) {
+    free_func (ring->items[tail & ring->mask]);
+    ring->items[tail & ring->mask] = NULL;
+  }
+  g_atomic_int_set (&ring->tail, tail);
+}
+
+/* wake up the other side sleeping in _push() or _pop() */
+static inline void
+gst_unix_ring_wake (GstUNIXRing * ring)
+{
+  if (g_atomic_int_get (&ring->waiting)) {
+    g_mutex_lock (&ring->lock);
+    g_cond_broadcast (&ring->cond);
+    g_mutex_unlock (&ring->lock);
+  }
+}
+
+static inline guint
+gst_unix_ring_level (GstUNIXRing * ring)
+{
+  return (guint) g_atomic_int_get (&ring->head) -
+      (guint) g_atomic_int_get (&ring->tail);
+}
+
+/* queue @item. A full ring either makes this wait for a free slot or, when
+ * not @block, return FALSE right away. Also returns FALSE once closed */
+gboolean
+gst_unix_ring_push (GstUNIXRing * ring, gpointer item, gboolean block)
+{
+  guint head;
+
+  while (TRUE) {
+    if (G_UNLIKELY (g_atomic_int_get (&ring->closed)))
+      return FALSE;
+
+    if (gst_unix_ring_level (ring) < ring->size)
+      break;
+    if (!block)
+      return FALSE;
+
+    g_mutex_lock (&ring->lock);
+    g_atomic_int_inc (&ring->waiting);
+    while (gst_unix_ring_level (ring) >= ring->size &&
+        !g_atomic_int_get (&ring->closed))
+      g_cond_wait (&ring->cond, &ring->lock);
+    g_atomic_int_add (&ring->waiting, -1);
+    g_mutex_unlock (&ring->lock);
+  }
+
+  head = g_atomic_int_get (&ring->head);
+  ring->items[head & ring->mask] = item;
+  /* publishes the item, the set is a full barrier */
+  g_atomic_int_set (&ring->head, head + 1);
+  gst_unix_ring_wake (ring);
+
+  return TRUE;
+}
+
+/* make a producer waiting in _push() and all further pushes fail */
+void
+gst_unix_ring_set_closed (GstUNIXRing * ring, gboolean closed)
+{
+  g_mutex_lock (&ring->lock);
+  g_atomic_int_set (&ring->closed, closed);
+  g_cond_broadcast (&ring->cond);
+  g_mutex_unlock (&ring->lock);
+}
+
+/* get the next item, blocking until there is one. Returns NULL when
+ * flushing */
+gpointer
+gst_unix_ring_pop (GstUNIXRing * ring)
+{
+  gpointer item;
+  guint tail;
+
+  while (TRUE) {
+    if (G_UNLIKELY (g_atomic_int_get (&ring->flushing)))
+      return NULL;
+
+    if (gst_unix_ring_level (ring) > 0)
+      break;
+
+    g_mutex_lock (&ring->lock);
+    g_atomic_int_inc (&ring->waiting);
+    while (gst_unix_ring_level (ring) == 0 &&
+        !g_atomic_int_get (&ring->flushing))
+      g_cond_wait (&ring->cond, &ring->lock);
+    g_atomic_int_add (&ring->waiting, -1);
+    g_mutex_unlock (&ring->lock);
+  }
+
+  tail = g_atomic_int_get (&ring->tail);
+  item = ring->items[tail & ring->mask];
+  ring->items[tail & ring->mask] = NULL;
+  g_atomic_int_set (&ring->tail, tail + 1);
+  gst_unix_ring_wake (ring);
+
+  return item;
+}
+
+void
+gst_unix_ring_set_flushing (GstUNIXRing * ring, gboolean flushing)
+{
+  g_mutex_lock (&ring->lock);
+  g_atomic_int_set (&ring->flushing, flushing);
+  g_cond_broadcast (&ring->cond);
+  g_mutex_unlock (&ring->lock);
+}
+
+guint
+gst_unix_ring_get_size (GstUNIXRing * ring)
+{
+  return ring->size;
+}
+
+/* number of queued items, exact only on the consumer or producer side */
+guint
+gst_unix_ring_get_level (GstUNIXRing * ring)
+{
+  return gst_unix_ring_level (ring);
+}
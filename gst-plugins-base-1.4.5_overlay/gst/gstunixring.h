@@ -0,0 +1,68 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_RING_H__
+#define __GST_UNIX_RING_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_UNIX_RING_OVERFLOW (gst_unix_ring_overflow_get_type())
+
+/**
+ * GstUNIXRingOverflow:
+ * @GST_UNIX_RING_OVERFLOW_BLOCK: the producer waits for a free slot
+ * @GST_UNIX_RING_OVERFLOW_DROP: the producer drops what it could not queue
+ *
+ * What happens when the producer of a full #GstUNIXRing has another item.
+ */
+typedef enum {
+  GST_UNIX_RING_OVERFLOW_BLOCK,
+  GST_UNIX_RING_OVERFLOW_DROP
+} GstUNIXRingOverflow;
+
+typedef struct _GstUNIXRing GstUNIXRing;
+
+GType        gst_unix_ring_overflow_get_type (void);
+
+GstUNIXRing *gst_unix_ring_new           (guint size);
+void         gst_unix_ring_free          (GstUNIXRing * ring,
+                                          GDestroyNotify free_func);
+void         gst_unix_ring_clear         (GstUNIXRing * ring,
+                                          GDestroyNotify free_func);
+
+/* producer side */
+gboolean     gst_unix_ring_push          (GstUNIXRing * ring, gpointer item,
+                                          gboolean block);
+void         gst_unix_ring_set_closed    (GstUNIXRing * ring,
+                                          gboolean closed);
+
+/* consumer side */
+gpointer     gst_unix_ring_pop           (GstUNIXRing * ring);
+void         gst_unix_ring_set_flushing  (GstUNIXRing * ring,
+                                          gboolean flushing);
+
+guint        gst_unix_ring_get_size      (GstUNIXRing * ring);
+guint        gst_unix_ring_get_level     (GstUNIXRing * ring);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_RING_H__ */
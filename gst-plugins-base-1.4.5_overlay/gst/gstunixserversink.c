@@ -30,6 +30,63 @@
  * # client:
  * gst-launch unixclientsrc path=/tmp/unix.sock ! fdsink fd=2
  * ]| 
+ * <title>Striped transfer</title>
+ * |[
+ * # server:
+ * gst-launch videotestsrc ! video/x-raw,width=3840,height=2160 ! unixserversink protocol=framed path=/tmp/unix.sock
+ * # client:
+ * gst-launch unixclientsrc protocol=framed stripes=4 path=/tmp/unix.sock ! fakesink
+ * ]| with protocol=framed a client may ask for each buffer to be split
+ * across several parallel connections, each one written by its own thread.
+ *
+ * A unixclientsrc in the same process as the unixserversink serving its
+ * path bypasses the socket and receives references to the buffers directly.
+ * It is disconnected when it lags more than #GstMultiHandleSink:buffers-max
+ * buffers, or #GstMultiHandleSink:units-max buffers or bytes, behind.
+ *
+ * <title>Renditions</title>
+ * |[
+ * # server:
+ * gst-launch audiotestsrc ! audio/x-raw,format=S32LE,rate=48000,channels=2 ! unixserversink protocol=framed path=/tmp/unix.sock
+ * # client:
+ * gst-launch unixclientsrc protocol=framed rendition="audio/x-raw,format=S16LE,rate=16000,channels=1" path=/tmp/unix.sock ! fakesink
+ * ]| a framed client may ask for a rendition of a raw audio stream in
+ * another sample format, rate or channel count. The server converts once
+ * per distinct rendition, for as long as it has subscribers.
+ *
+ * New clients are accepted, and framed clients greeted, by a separate
+ * thread; only fully set up clients are handed to the thread writing to the
+ * existing ones, so a burst of connections does not delay delivery. Hellos
+ * are read as they arrive, a client that stays silent is dropped after a
+ * second without holding up the others.
+ *
+ * <title>Socket buffers</title>
+ * |[
+ * gst-launch audiotestsrc ! unixserversink latency-target=20 path=/tmp/unix.sock
+ * ]| size the send buffer of every client to hold 20 ms of the measured
+ * bitrate instead of the kernel default, resizing as the bitrate changes.
+ * Renditions and stripes are sized for the share of the stream they carry.
+ * send-buffer-size sets a fixed size instead. Linux caps send buffers at
+ * net.core.wmem_max; send-buffer-size in stats is what the kernel granted
+ * the socket sized last, and a warning is posted the first time it is less
+ * than asked for.
+ *
+ * <title>Zero-copy send</title>
+ * |[
+ * # server:
+ * gst-launch videotestsrc ! video/x-raw,width=3840,height=2160 ! unixserversink protocol=framed splice-threshold=262144 path=/tmp/unix.sock
+ * # client:
+ * gst-launch unixclientsrc protocol=framed stripes=2 path=/tmp/unix.sock ! fakesink
+ * ]| on Linux, stripes of at least splice-threshold bytes are handed to the
+ * kernel with vmsplice and splice instead of being copied into the socket
+ * buffer of every striped client; each buffer stays referenced until its
+ * client read it. Splicing needs a blocking writer per connection, so it
+ * only applies to striped clients, which have a thread per stripe anyway.
+ * A client on a single connection can get one by asking for a group of one
+ * stripe, with sender-thread on unixclientsrc.
+ * Smaller stripes are copied as before, and all other clients keep being
+ * served from the queue of multisocketsink with its burst, recovery and
+ * timeout handling. bytes-spliced in stats shows how much took the path.
  * </refsect2>
  */
 
@@ -40,9 +97,29 @@
 #include <string.h>             /* memset */
 #include <sys/stat.h>
 
+#include <gst/gstatomicqueue.h>
+
 #include "gstunixserversink.h"
+#include "gstunixlatency.h"
+#include "gstunixrendition.h"
+#include "gstunixtrace.h"
+#include "gstunixsockbuf.h"
+#include "gstunixsplice.h"
 
 #define UNIX_BACKLOG             5
+#define HANDSHAKE_TIMEOUT        1      /* seconds */
+#define STRIPE_QUEUE_MAX         16
+#define STRIPE_GROUP_TIMEOUT     5      /* seconds to connect all stripes */
+
+#define DEFAULT_PROTOCOL         GST_UNIX_PROTOCOL_RAW
+#define DEFAULT_CPU_AFFINITY     NULL
+#define DEFAULT_SCHED_POLICY     GST_UNIX_SCHED_POLICY_OTHER
+#define DEFAULT_SCHED_PRIORITY   1
+#define DEFAULT_SEND_TIMESTAMPS  FALSE
+#define DEFAULT_TRACE_TIMING     FALSE
+#define DEFAULT_LATENCY_TARGET   0
+#define DEFAULT_SEND_BUFFER_SIZE 0
+#define DEFAULT_SPLICE_THRESHOLD 0
 
 GST_DEBUG_CATEGORY_STATIC (unixserversink_debug);
 #define GST_CAT_DEFAULT (unixserversink_debug)
@@ -51,12 +128,94 @@ enum
 {
   PROP_0,
   PROP_PATH,
+  PROP_PROTOCOL,
+  PROP_CPU_AFFINITY,
+  PROP_SCHED_POLICY,
+  PROP_SCHED_PRIORITY,
+  PROP_STATS,
+  PROP_SEND_TIMESTAMPS,
+  PROP_TRACE_TIMING,
+  PROP_LATENCY_TARGET,
+  PROP_SEND_BUFFER_SIZE,
+  PROP_SPLICE_THRESHOLD,
 };
 
+/* never dispatches; it configures the thread iterating the main context the
+ * first time it runs and then records every wakeup of that thread */
+typedef struct
+{
+  GSource source;
+  GstUNIXServerSink *sink;
+  gboolean configured;
+} GstUNIXIOSource;
+
+/* adds the clients prepared by the accept thread from the thread writing
+ * to the clients */
+typedef struct
+{
+  GSource source;
+  GstUNIXServerSink *sink;
+} GstUNIXHandoffSource;
+
+/* a framed client whose hello is still being read by the accept thread */
+typedef struct
+{
+  GstUNIXServerSink *sink;
+  GSocket *socket;
+  GSource *source;              /* readable */
+  GSource *timeout;             /* gave up waiting for the hello */
+  GstUNIXFrameHeader header;
+  gchar *hello;
+  gsize received;
+} GstUNIXGreeting;
+
+/* one connection of a striped client */
+typedef struct
+{
+  GstUNIXStripeGroup *group;
+  guint index;
+  GSocket *socket;
+  GThread *thread;
+  GQueue queue;                 /* GstUNIXStripeJob, protected by stripe_lock */
+  GstUNIXSplice *splice;        /* only used from the stripe thread */
+  guint splice_threshold;
+} GstUNIXStripe;
+
+/* all connections of a striped client, identified by the stripe-group id the
+ * client sent in its hello */
+struct _GstUNIXStripeGroup
+{
+  GstUNIXServerSink *sink;
+  guint64 id;
+  guint count;
+  guint connected;
+  gboolean running;
+  gboolean broken;
+  gint64 created;               /* monotonic time in microseconds */
+  GstUNIXStripe *stripes;
+  GCancellable *cancellable;
+};
+
+typedef struct
+{
+  GstBuffer *buffer;            /* NULL asks the stripe thread to exit */
+  guint64 seq;
+  GstClockTime send_time;
+} GstUNIXStripeJob;
+
 static void gst_unix_server_sink_finalize (GObject * gobject);
 
 static gboolean gst_unix_server_sink_init_send (GstMultiHandleSink * this);
 static gboolean gst_unix_server_sink_close (GstMultiHandleSink * this);
+static GstFlowReturn gst_unix_server_sink_render (GstBaseSink * bsink,
+    GstBuffer * buf);
+static gboolean gst_unix_server_sink_event (GstBaseSink * bsink,
+    GstEvent * event);
+static void gst_unix_server_sink_free_group (GstUNIXStripeGroup * group);
+static void gst_unix_server_sink_push_rendition_event (GstUNIXServerSink *
+    sink, GstEvent * event);
+static void gst_unix_server_sink_push_renditions (GstUNIXServerSink * sink,
+    GstBuffer * buf, GstClockTime send_time);
 static void gst_unix_server_sink_removed (GstMultiHandleSink * sink,
     GstMultiSinkHandle handle);
 
@@ -74,10 +233,12 @@ gst_unix_server_sink_class_init (GstUNIXServerSinkClass * klass)
 {
   GObjectClass *gobject_class;
   GstElementClass *gstelement_class;
+  GstBaseSinkClass *gstbasesink_class;
   GstMultiHandleSinkClass *gstmultihandlesink_class;
 
   gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
+  gstbasesink_class = (GstBaseSinkClass *) klass;
   gstmultihandlesink_class = (GstMultiHandleSinkClass *) klass;
 
   gobject_class->set_property = gst_unix_server_sink_set_property;
@@ -88,11 +249,62 @@ gst_unix_server_sink_class_init (GstUNIXServerSinkClass * klass)
       g_param_spec_string ("path", "path", "The UNIX socket path to listen on",
           UNIX_DEFAULT_PATH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_PROTOCOL,
+      g_param_spec_enum ("protocol", "Protocol",
+          "The wire protocol spoken with clients", GST_TYPE_UNIX_PROTOCOL,
+          DEFAULT_PROTOCOL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CPU_AFFINITY,
+      g_param_spec_string ("cpu-affinity", "CPU affinity",
+          "CPUs to pin the sending threads to, e.g. \"0-3,8\". Their memory "
+          "is then preferably allocated on the matching NUMA node",
+          DEFAULT_CPU_AFFINITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SCHED_POLICY,
+      g_param_spec_enum ("sched-policy", "Scheduling policy",
+          "Scheduling class of the sending threads", GST_TYPE_UNIX_SCHED_POLICY,
+          DEFAULT_SCHED_POLICY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SCHED_PRIORITY,
+      g_param_spec_int ("sched-priority", "Scheduling priority",
+          "Real-time priority for the fifo and rr scheduling policies", 1, 99,
+          DEFAULT_SCHED_PRIORITY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Stats", "Statistics of the sink",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SEND_TIMESTAMPS,
+      g_param_spec_boolean ("send-timestamps", "Send timestamps",
+          "Stamp framed buffers with the monotonic time they were received, "
+          "so clients can measure transport latency", DEFAULT_SEND_TIMESTAMPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_TRACE_TIMING,
+      g_param_spec_boolean ("trace-timing", "Trace timing",
+          "Aggregate the time spent in render into a histogram in stats",
+          DEFAULT_TRACE_TIMING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LATENCY_TARGET,
+      g_param_spec_uint ("latency-target", "Latency target",
+          "Size the send buffer of every client to hold this many ms of the "
+          "measured bitrate (0 = kernel default)", 0, G_MAXUINT,
+          DEFAULT_LATENCY_TARGET, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SEND_BUFFER_SIZE,
+      g_param_spec_int ("send-buffer-size", "Send buffer size",
+          "Send buffer size of every client in bytes, overrides "
+          "latency-target (0 = automatic)", 0, G_MAXINT,
+          DEFAULT_SEND_BUFFER_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SPLICE_THRESHOLD,
+      g_param_spec_uint ("splice-threshold", "Splice threshold",
+          "Send stripes of at least this many bytes to striped clients with "
+          "vmsplice and splice instead of copying them (0 = never)", 0, G_MAXUINT,
+          DEFAULT_SPLICE_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "UNIX server sink", "Sink/Local",
       "Send data as a server via a UNIX socket",
       "Stefan Junker <code at stefanjunker dot de>");
 
+  gstbasesink_class->render = gst_unix_server_sink_render;
+  gstbasesink_class->event = gst_unix_server_sink_event;
+
   gstmultihandlesink_class->init = gst_unix_server_sink_init_send;
   gstmultihandlesink_class->close = gst_unix_server_sink_close;
   gstmultihandlesink_class->removed = gst_unix_server_sink_removed;
@@ -105,6 +317,44 @@ gst_unix_server_sink_init (GstUNIXServerSink * this)
 {
   this->path = g_strdup (UNIX_DEFAULT_PATH);
   this->server_socket = NULL;
+  this->protocol = DEFAULT_PROTOCOL;
+  this->seq = 0;
+  this->send_timestamps = DEFAULT_SEND_TIMESTAMPS;
+  this->trace_timing = DEFAULT_TRACE_TIMING;
+  gst_unix_histogram_reset (&this->render_time);
+  this->latency_target = DEFAULT_LATENCY_TARGET;
+  this->send_buffer_size = DEFAULT_SEND_BUFFER_SIZE;
+  this->sndbuf = 0;
+  this->sndbuf_applied = 0;
+  this->sndbuf_clamped = FALSE;
+  gst_unix_bitrate_reset (&this->bitrate);
+  this->splice_threshold = DEFAULT_SPLICE_THRESHOLD;
+  this->spliced = 0;
+  this->local = NULL;
+
+  g_mutex_init (&this->stripe_lock);
+  g_cond_init (&this->stripe_cond);
+  this->stripe_groups = NULL;
+
+  g_mutex_init (&this->rendition_lock);
+  this->renditions = NULL;
+
+  this->thread_config.cpus = DEFAULT_CPU_AFFINITY;
+  this->thread_config.policy = DEFAULT_SCHED_POLICY;
+  this->thread_config.priority = DEFAULT_SCHED_PRIORITY;
+  this->io_source = NULL;
+  this->accept_context = NULL;
+  this->accept_loop = NULL;
+  this->accept_thread = NULL;
+  this->accept_cancellable = g_cancellable_new ();
+  this->greetings = NULL;
+  this->pending = gst_atomic_queue_new (16);
+  this->handoff_source = NULL;
+  this->sweep_source = NULL;
+  this->accepted = 0;
+  this->rejected = 0;
+  gst_unix_jitter_reset (&this->io_jitter);
+  gst_unix_jitter_reset (&this->render_jitter);
 }
 
 static void
@@ -131,40 +381,1041 @@ gst_unix_server_sink_finalize (GObject * gobject)
     this->path = NULL;
   }
 
+  g_mutex_clear (&this->stripe_lock);
+  g_cond_clear (&this->stripe_cond);
+  g_mutex_clear (&this->rendition_lock);
+  g_object_unref (this->accept_cancellable);
+  gst_atomic_queue_unref (this->pending);
+  g_free (this->thread_config.cpus);
+  this->thread_config.cpus = NULL;
+
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
 }
 
-/* handle a read request on the server,
- * which indicates a new client connection */
+/* pin the calling thread as configured */
+static void
+gst_unix_server_sink_configure_thread (GstUNIXServerSink * sink)
+{
+  GstUNIXThreadConfig config;
+
+  GST_OBJECT_LOCK (sink);
+  config = sink->thread_config;
+  config.cpus = g_strdup (config.cpus);
+  GST_OBJECT_UNLOCK (sink);
+
+  gst_unix_thread_config_apply (&config, GST_OBJECT_CAST (sink));
+  g_free (config.cpus);
+}
+
 static gboolean
-gst_unix_server_sink_handle_server_read (GstUNIXServerSink * sink)
+gst_unix_io_source_prepare (GSource * source, gint * timeout)
+{
+  *timeout = -1;
+  return FALSE;
+}
+
+static gboolean
+gst_unix_io_source_check (GSource * source)
+{
+  GstUNIXIOSource *io = (GstUNIXIOSource *) source;
+
+  if (G_UNLIKELY (!io->configured)) {
+    gst_unix_server_sink_configure_thread (io->sink);
+    io->configured = TRUE;
+  }
+
+  GST_OBJECT_LOCK (io->sink);
+  gst_unix_jitter_update (&io->sink->io_jitter);
+  GST_OBJECT_UNLOCK (io->sink);
+
+  return FALSE;
+}
+
+static gboolean
+gst_unix_io_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
 {
+  return TRUE;
+}
+
+static GSourceFuncs gst_unix_io_source_funcs = {
+  gst_unix_io_source_prepare,
+  gst_unix_io_source_check,
+  gst_unix_io_source_dispatch,
+  NULL
+};
+
+static gboolean
+gst_unix_handoff_source_prepare (GSource * source, gint * timeout)
+{
+  GstUNIXHandoffSource *handoff = (GstUNIXHandoffSource *) source;
+
+  *timeout = -1;
+  return gst_atomic_queue_length (handoff->sink->pending) > 0;
+}
+
+static gboolean
+gst_unix_handoff_source_check (GSource * source)
+{
+  GstUNIXHandoffSource *handoff = (GstUNIXHandoffSource *) source;
+
+  return gst_atomic_queue_length (handoff->sink->pending) > 0;
+}
+
+static gboolean
+gst_unix_handoff_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
+{
+  GstUNIXServerSink *sink = ((GstUNIXHandoffSource *) source)->sink;
   GstMultiSinkHandle handle;
   GSocket *client_socket;
+
+  while ((client_socket = gst_atomic_queue_pop (sink->pending))) {
+    handle.socket = client_socket;
+    /* gst_multi_handle_sink_add does not take ownership of client_socket */
+    gst_multi_handle_sink_add (GST_MULTI_HANDLE_SINK (sink), handle);
+    GST_UNIX_TRACE2 (handoff, sink, g_socket_get_fd (client_socket));
+
+    GST_DEBUG_OBJECT (sink, "Received new client. %p", client_socket);
+    g_object_unref (client_socket);
+  }
+
+  return TRUE;
+}
+
+static GSourceFuncs gst_unix_handoff_source_funcs = {
+  gst_unix_handoff_source_prepare,
+  gst_unix_handoff_source_check,
+  gst_unix_handoff_source_dispatch,
+  NULL
+};
+
+/* send buffer size for a client getting 1/@share of the stream, 0 to leave
+ * the kernel default */
+static gint
+gst_unix_server_sink_client_sndbuf (GstUNIXServerSink * sink, guint share)
+{
+  gint size = 0;
+
+  GST_OBJECT_LOCK (sink);
+  if (sink->send_buffer_size > 0)
+    size = sink->send_buffer_size;
+  else if (sink->sndbuf > 0)
+    size = MAX (sink->sndbuf / share, GST_UNIX_SOCKBUF_MIN);
+  GST_OBJECT_UNLOCK (sink);
+
+  return size;
+}
+
+/* set the send buffer of @socket to @size, remembering what the kernel
+ * granted */
+static void
+gst_unix_server_sink_apply_sndbuf (GstUNIXServerSink * sink,
+    GSocket * socket, gint size)
+{
+  gint applied;
+  gboolean warn = FALSE;
+
+  applied = gst_unix_socket_set_buffer_size (socket, TRUE, size);
+  if (applied < 0)
+    return;
+
+  GST_OBJECT_LOCK (sink);
+  sink->sndbuf_applied = applied;
+  if (gst_unix_sockbuf_clamped (size, applied) && !sink->sndbuf_clamped)
+    warn = sink->sndbuf_clamped = TRUE;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (warn)
+    GST_ELEMENT_WARNING (sink, RESOURCE, SETTINGS, (NULL),
+        ("Send buffer of %d bytes wanted, got %d; raise net.core.wmem_max",
+            size, applied));
+}
+
+static void
+gst_unix_server_sink_fill_header (GstUNIXFrameHeader * header,
+    GstBuffer * buf, guint64 seq, GstClockTime send_time)
+{
+  header->seq = seq;
+  header->send_time = send_time;
+  header->total_size = gst_buffer_get_size (buf);
+  header->pts = GST_BUFFER_PTS (buf);
+  header->duration = GST_BUFFER_DURATION (buf);
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT))
+    header->flags |= GST_UNIX_FRAME_FLAG_DISCONT;
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
+    header->flags |= GST_UNIX_FRAME_FLAG_DELTA_UNIT;
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER))
+    header->flags |= GST_UNIX_FRAME_FLAG_HEADER;
+}
+
+/* send this stripe's share of @job->buffer */
+static gboolean
+gst_unix_server_sink_send_stripe (GstUNIXStripe * stripe,
+    GstUNIXStripeJob * job)
+{
+  GstUNIXStripeGroup *group = stripe->group;
+  GstUNIXFrameHeader header;
+  GOutputVector vectors[2];
+  GstMapInfo map;
+  gsize chunk, offset, size, total;
   GError *err = NULL;
+  gboolean ret;
+
+  /* the last stripes may end up with an empty chunk, they still get a header
+   * so the client sees every sequence number on every connection */
+  total = gst_buffer_get_size (job->buffer);
+  chunk = (total + group->count - 1) / group->count;
+  offset = MIN (total, chunk * stripe->index);
+  size = MIN (chunk, total - offset);
+
+  gst_unix_frame_header_init (&header, GST_UNIX_MESSAGE_BUFFER, size);
+  gst_unix_server_sink_fill_header (&header, job->buffer, job->seq,
+      job->send_time);
+  header.offset = offset;
+
+  if (stripe->splice && size >= stripe->splice_threshold) {
+    ret = gst_unix_splice_send (stripe->splice, &header, sizeof (header),
+        job->buffer, offset, size, group->cancellable, &err);
+    if (ret) {
+      GST_OBJECT_LOCK (group->sink);
+      group->sink->spliced += size;
+      GST_OBJECT_UNLOCK (group->sink);
+    }
+  } else {
+    if (!gst_buffer_map (job->buffer, &map, GST_MAP_READ))
+      return FALSE;
+
+    vectors[0].buffer = &header;
+    vectors[0].size = sizeof (header);
+    vectors[1].buffer = map.data + offset;
+    vectors[1].size = size;
+
+    ret = gst_unix_socket_send_all (stripe->socket, vectors, 2,
+        group->cancellable, &err);
+    gst_buffer_unmap (job->buffer, &map);
+  }
+  GST_UNIX_TRACE3 (stripe_send, group->sink, job->seq, stripe->index);
+  if (!ret) {
+    GST_DEBUG_OBJECT (group->sink, "stripe %u of group %" G_GINT64_MODIFIER
+        "x failed: %s", stripe->index, group->id, err->message);
+    g_clear_error (&err);
+  }
+
+  return ret;
+}
+
+static gpointer
+gst_unix_server_sink_stripe_thread (GstUNIXStripe * stripe)
+{
+  GstUNIXStripeGroup *group = stripe->group;
+  GstUNIXServerSink *sink = group->sink;
+  GstUNIXStripeJob *job;
+  GError *err = NULL;
+  gboolean ok, drain;
+
+  gst_unix_server_sink_configure_thread (sink);
+
+  GST_OBJECT_LOCK (sink);
+  stripe->splice_threshold = sink->splice_threshold;
+  GST_OBJECT_UNLOCK (sink);
+  if (stripe->splice_threshold > 0) {
+    stripe->splice = gst_unix_splice_new (stripe->socket, &err);
+    if (!stripe->splice) {
+      GST_WARNING_OBJECT (sink, "stripe %u of group %" G_GINT64_MODIFIER
+          "x falls back to copying: %s", stripe->index, group->id,
+          err->message);
+      g_clear_error (&err);
+    }
+  }
+
+  while (TRUE) {
+    g_mutex_lock (&sink->stripe_lock);
+    while (g_queue_is_empty (&stripe->queue))
+      g_cond_wait (&sink->stripe_cond, &sink->stripe_lock);
+    job = g_queue_pop_head (&stripe->queue);
+    g_mutex_unlock (&sink->stripe_lock);
+
+    if (!job->buffer) {
+      g_slice_free (GstUNIXStripeJob, job);
+      break;
+    }
+
+    ok = gst_unix_server_sink_send_stripe (stripe, job);
+    gst_buffer_unref (job->buffer);
+    g_slice_free (GstUNIXStripeJob, job);
+
+    if (!ok) {
+      g_mutex_lock (&sink->stripe_lock);
+      group->broken = TRUE;
+      g_mutex_unlock (&sink->stripe_lock);
+      break;
+    }
+  }
+
+  /* a healthy client still gets to read what was spliced before its buffers
+   * are released, a broken one is going away anyway */
+  if (stripe->splice) {
+    g_mutex_lock (&sink->stripe_lock);
+    drain = !group->broken;
+    g_mutex_unlock (&sink->stripe_lock);
+    gst_unix_splice_free (stripe->splice, drain);
+    stripe->splice = NULL;
+  }
+
+  return NULL;
+}
+
+/* called with stripe_lock */
+static GstUNIXStripeGroup *
+gst_unix_server_sink_find_group (GstUNIXServerSink * sink, guint64 id)
+{
+  GList *walk;
+
+  for (walk = sink->stripe_groups; walk; walk = walk->next) {
+    GstUNIXStripeGroup *group = walk->data;
+
+    if (group->id == id)
+      return group;
+  }
+  return NULL;
+}
+
+static gboolean
+gst_unix_server_sink_add_stripe (GstUNIXServerSink * sink,
+    GSocket * client_socket, guint64 id, guint index, guint count)
+{
+  GstUNIXStripeGroup *group;
+  GstUNIXStripe *stripe;
+  gint size;
+  guint i;
+
+  /* every stripe carries its share of the stream */
+  size = gst_unix_server_sink_client_sndbuf (sink, count);
+  if (size > 0)
+    gst_unix_server_sink_apply_sndbuf (sink, client_socket, size);
+
+  if (count == 0 || index >= count)
+    goto invalid_stripe;
+
+  g_mutex_lock (&sink->stripe_lock);
+  group = gst_unix_server_sink_find_group (sink, id);
+  if (!group) {
+    group = g_slice_new0 (GstUNIXStripeGroup);
+    group->sink = sink;
+    group->id = id;
+    group->count = count;
+    group->created = g_get_monotonic_time ();
+    group->stripes = g_new0 (GstUNIXStripe, count);
+    group->cancellable = g_cancellable_new ();
+    for (i = 0; i < count; i++) {
+      group->stripes[i].group = group;
+      group->stripes[i].index = i;
+      g_queue_init (&group->stripes[i].queue);
+    }
+    sink->stripe_groups = g_list_prepend (sink->stripe_groups, group);
+  }
+
+  if (group->count != count || group->running ||
+      group->stripes[index].socket)
+    goto invalid_group;
+
+  stripe = &group->stripes[index];
+  stripe->socket = g_object_ref (client_socket);
+  group->connected++;
+
+  GST_DEBUG_OBJECT (sink, "stripe %u/%u of group %" G_GINT64_MODIFIER
+      "x connected", index, count, id);
+
+  if (group->connected == count) {
+    for (i = 0; i < count; i++)
+      group->stripes[i].thread = g_thread_new ("unixserversink-stripe",
+          (GThreadFunc) gst_unix_server_sink_stripe_thread,
+          &group->stripes[i]);
+    group->running = TRUE;
+    GST_DEBUG_OBJECT (sink, "stripe group %" G_GINT64_MODIFIER "x complete",
+        id);
+  }
+  g_mutex_unlock (&sink->stripe_lock);
+
+  return TRUE;
+
+  /* ERRORS */
+invalid_group:
+  {
+    g_mutex_unlock (&sink->stripe_lock);
+    goto invalid_stripe;
+  }
+invalid_stripe:
+  {
+    GST_WARNING_OBJECT (sink, "invalid stripe %u/%u for group %"
+        G_GINT64_MODIFIER "x", index, count, id);
+    return FALSE;
+  }
+}
+
+/* drop groups whose client did not connect all stripes in time, e.g.
+ * because it died half way. Runs in the accept thread */
+static gboolean
+gst_unix_server_sink_sweep_groups (GstUNIXServerSink * sink)
+{
+  GList *walk, *next, *dead = NULL;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&sink->stripe_lock);
+  for (walk = sink->stripe_groups; walk; walk = next) {
+    GstUNIXStripeGroup *group = walk->data;
+
+    next = walk->next;
+
+    if (group->running ||
+        now - group->created < STRIPE_GROUP_TIMEOUT * G_USEC_PER_SEC)
+      continue;
+
+    GST_WARNING_OBJECT (sink, "stripe group %" G_GINT64_MODIFIER "x only "
+        "connected %u of %u stripes, dropping", group->id, group->connected,
+        group->count);
+    sink->stripe_groups = g_list_delete_link (sink->stripe_groups, walk);
+    dead = g_list_prepend (dead, group);
+  }
+  g_mutex_unlock (&sink->stripe_lock);
+
+  g_list_free_full (dead, (GDestroyNotify) gst_unix_server_sink_free_group);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gst_unix_server_sink_free_group (GstUNIXStripeGroup * group)
+{
+  GstUNIXServerSink *sink = group->sink;
+  GstUNIXStripeJob *job;
+  guint i;
+
+  GST_DEBUG_OBJECT (sink, "freeing stripe group %" G_GINT64_MODIFIER "x",
+      group->id);
+
+  g_mutex_lock (&sink->stripe_lock);
+  for (i = 0; i < group->count; i++) {
+    if (group->stripes[i].thread)
+      g_queue_push_tail (&group->stripes[i].queue,
+          g_slice_new0 (GstUNIXStripeJob));
+  }
+  g_cond_broadcast (&sink->stripe_cond);
+  g_mutex_unlock (&sink->stripe_lock);
+
+  g_cancellable_cancel (group->cancellable);
+
+  for (i = 0; i < group->count; i++) {
+    GstUNIXStripe *stripe = &group->stripes[i];
+
+    if (stripe->thread)
+      g_thread_join (stripe->thread);
+
+    while ((job = g_queue_pop_head (&stripe->queue))) {
+      if (job->buffer)
+        gst_buffer_unref (job->buffer);
+      g_slice_free (GstUNIXStripeJob, job);
+    }
+
+    if (stripe->socket) {
+      g_socket_close (stripe->socket, NULL);
+      g_object_unref (stripe->socket);
+    }
+  }
+
+  g_object_unref (group->cancellable);
+  g_free (group->stripes);
+  g_slice_free (GstUNIXStripeGroup, group);
+}
+
+/* hand @buf to the threads of every complete stripe group. A group that
+ * cannot keep up is disconnected, like a lagging client would be */
+static void
+gst_unix_server_sink_queue_stripes (GstUNIXServerSink * sink, GstBuffer * buf,
+    guint64 seq, GstClockTime send_time)
+{
+  GList *walk, *next, *dead = NULL;
+  guint i;
+
+  g_mutex_lock (&sink->stripe_lock);
+  for (walk = sink->stripe_groups; walk; walk = next) {
+    GstUNIXStripeGroup *group = walk->data;
+
+    next = walk->next;
+
+    if (!group->running)
+      continue;
+
+    for (i = 0; i < group->count && !group->broken; i++) {
+      if (g_queue_get_length (&group->stripes[i].queue) >= STRIPE_QUEUE_MAX) {
+        GST_WARNING_OBJECT (sink, "stripe group %" G_GINT64_MODIFIER
+            "x lagging, disconnecting", group->id);
+        group->broken = TRUE;
+      }
+    }
+
+    if (group->broken) {
+      sink->stripe_groups = g_list_delete_link (sink->stripe_groups, walk);
+      dead = g_list_prepend (dead, group);
+      continue;
+    }
+
+    for (i = 0; i < group->count; i++) {
+      GstUNIXStripeJob *job = g_slice_new (GstUNIXStripeJob);
+
+      job->buffer = gst_buffer_ref (buf);
+      job->seq = seq;
+      job->send_time = send_time;
+      g_queue_push_tail (&group->stripes[i].queue, job);
+    }
+    GST_UNIX_TRACE3 (stripe_enqueue, sink, seq, group->count);
+  }
+  g_cond_broadcast (&sink->stripe_cond);
+  g_mutex_unlock (&sink->stripe_lock);
+
+  g_list_free_full (dead, (GDestroyNotify) gst_unix_server_sink_free_group);
+}
+
+/* wrap @buf into a buffer carrying a frame header in front, sharing the
+ * payload memory */
+static GstBuffer *
+gst_unix_server_sink_frame_buffer (GstUNIXServerSink * sink, GstBuffer * buf,
+    guint64 seq, GstClockTime send_time)
+{
+  GstUNIXFrameHeader *header;
+  GstBuffer *framed;
+
+  header = g_new (GstUNIXFrameHeader, 1);
+  gst_unix_frame_header_init (header, GST_UNIX_MESSAGE_BUFFER,
+      gst_buffer_get_size (buf));
+  gst_unix_server_sink_fill_header (header, buf, seq, send_time);
+
+  framed = gst_buffer_copy (buf);
+  gst_buffer_prepend_memory (framed,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, header,
+          sizeof (GstUNIXFrameHeader), 0, sizeof (GstUNIXFrameHeader), header,
+          g_free));
+
+  return framed;
+}
+
+/* size the send buffers of all clients for the measured bitrate */
+static void
+gst_unix_server_sink_resize_clients (GstUNIXServerSink * sink)
+{
+  GstMultiHandleSink *mhsink = GST_MULTI_HANDLE_SINK (sink);
+  GList *walk;
+  guint64 rate;
+  gint size;
+  guint i;
+
+  GST_OBJECT_LOCK (sink);
+  rate = sink->bitrate.rate;
+  size = gst_unix_sockbuf_size_for (rate, sink->latency_target * GST_MSECOND);
+  if (!gst_unix_sockbuf_differs (sink->sndbuf, size)) {
+    GST_OBJECT_UNLOCK (sink);
+    return;
+  }
+  sink->sndbuf = size;
+  GST_OBJECT_UNLOCK (sink);
+
+  GST_DEBUG_OBJECT (sink, "bitrate %" G_GUINT64_FORMAT " bytes/s, send "
+      "buffers now %d bytes", rate, size);
+
+  CLIENTS_LOCK (sink);
+  for (walk = mhsink->clients; walk; walk = walk->next) {
+    GstMultiHandleClient *mhclient = walk->data;
+
+    gst_unix_server_sink_apply_sndbuf (sink, mhclient->handle.socket, size);
+  }
+  CLIENTS_UNLOCK (sink);
+
+  g_mutex_lock (&sink->stripe_lock);
+  for (walk = sink->stripe_groups; walk; walk = walk->next) {
+    GstUNIXStripeGroup *group = walk->data;
+
+    for (i = 0; i < group->count; i++) {
+      if (group->stripes[i].socket)
+        gst_unix_server_sink_apply_sndbuf (sink, group->stripes[i].socket,
+            MAX (size / group->count, GST_UNIX_SOCKBUF_MIN));
+    }
+  }
+  g_mutex_unlock (&sink->stripe_lock);
+}
+
+static GstFlowReturn
+gst_unix_server_sink_render_buffer (GstUNIXServerSink * sink, GstBuffer * buf)
+{
+  GstBaseSink *bsink = GST_BASE_SINK_CAST (sink);
+  GstBuffer *framed;
+  GstFlowReturn ret;
+  guint64 seq;
+  GstClockTime send_time = 0;
+  gboolean resize;
+
+  GST_OBJECT_LOCK (sink);
+  gst_unix_jitter_update (&sink->render_jitter);
+  resize = gst_unix_bitrate_update (&sink->bitrate, gst_buffer_get_size (buf))
+      && sink->latency_target && !sink->send_buffer_size;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (G_UNLIKELY (resize))
+    gst_unix_server_sink_resize_clients (sink);
+
+  if (sink->local)
+    gst_unix_local_server_push (sink->local, buf);
+
+  if (sink->protocol == GST_UNIX_PROTOCOL_RAW)
+    return GST_BASE_SINK_CLASS (parent_class)->render (bsink, buf);
+
+  seq = sink->seq++;
+  if (sink->send_timestamps)
+    send_time = gst_unix_latency_now ();
+
+  gst_unix_server_sink_queue_stripes (sink, buf, seq, send_time);
+  gst_unix_server_sink_push_renditions (sink, buf, send_time);
+
+  framed = gst_unix_server_sink_frame_buffer (sink, buf, seq, send_time);
+  ret = GST_BASE_SINK_CLASS (parent_class)->render (bsink, framed);
+  gst_buffer_unref (framed);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_unix_server_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstUNIXServerSink *sink = GST_UNIX_SERVER_SINK (bsink);
+  GstClockTime start = 0;
+  GstFlowReturn ret;
+
+  GST_UNIX_TRACE3 (render_start, sink, buf, gst_buffer_get_size (buf));
+  if (G_UNLIKELY (sink->trace_timing))
+    start = gst_unix_latency_now ();
+
+  ret = gst_unix_server_sink_render_buffer (sink, buf);
+
+  if (G_UNLIKELY (sink->trace_timing)) {
+    GstClockTime now = gst_unix_latency_now ();
+
+    GST_OBJECT_LOCK (sink);
+    gst_unix_histogram_record (&sink->render_time, now - start);
+    GST_OBJECT_UNLOCK (sink);
+  }
+  GST_UNIX_TRACE2 (render_end, sink, buf);
+
+  return ret;
+}
+
+static gboolean
+gst_unix_server_sink_event (GstBaseSink * bsink, GstEvent * event)
+{
+  GstUNIXServerSink *sink = GST_UNIX_SERVER_SINK (bsink);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_FLUSH_START:
+    case GST_EVENT_FLUSH_STOP:
+    case GST_EVENT_EOS:
+      gst_unix_server_sink_push_rendition_event (sink, event);
+      break;
+    default:
+      break;
+  }
+
+  if (sink->local) {
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_EOS:
+        gst_unix_local_server_set_eos (sink->local, TRUE);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        gst_unix_local_server_set_eos (sink->local, FALSE);
+        break;
+      default:
+        break;
+    }
+  }
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (bsink, event);
+}
+
+/* subscribe @client_socket to the rendition producing @caps, creating it
+ * when this is the first client asking for it */
+static gboolean
+gst_unix_server_sink_add_rendition (GstUNIXServerSink * sink,
+    GSocket * client_socket, const GstCaps * caps)
+{
+  GstUNIXRendition *rendition = NULL;
+  GError *err = NULL;
+  GList *walk;
+
+  g_mutex_lock (&sink->rendition_lock);
+  for (walk = sink->renditions; walk; walk = walk->next) {
+    if (gst_unix_rendition_has_caps (walk->data, caps)) {
+      rendition = walk->data;
+      break;
+    }
+  }
+  if (!rendition) {
+    rendition = gst_unix_rendition_new (GST_OBJECT_CAST (sink), caps, &err);
+    if (!rendition)
+      goto no_rendition;
+    /* a rendition has a bitrate of its own */
+    GST_OBJECT_LOCK (sink);
+    if (!sink->send_buffer_size)
+      gst_unix_rendition_set_latency_target (rendition,
+          sink->latency_target * GST_MSECOND);
+    GST_OBJECT_UNLOCK (sink);
+    sink->renditions = g_list_prepend (sink->renditions, rendition);
+  }
+  gst_unix_rendition_add_client (rendition, client_socket);
+  g_mutex_unlock (&sink->rendition_lock);
+
+  return TRUE;
+
+  /* ERRORS */
+no_rendition:
+  {
+    g_mutex_unlock (&sink->rendition_lock);
+    GST_WARNING_OBJECT (sink, "cannot serve rendition %" GST_PTR_FORMAT
+        ": %s", caps, err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+}
+
+/* convert @buf for every rendition, renditions without subscribers are torn
+ * down here */
+static void
+gst_unix_server_sink_push_renditions (GstUNIXServerSink * sink,
+    GstBuffer * buf, GstClockTime send_time)
+{
+  GList *walk, *next, *unused = NULL;
+  GstCaps *caps;
+
+  if (!g_atomic_pointer_get (&sink->renditions))
+    return;
+
+  caps = gst_pad_get_current_caps (GST_BASE_SINK_PAD (sink));
+
+  g_mutex_lock (&sink->rendition_lock);
+  for (walk = sink->renditions; walk; walk = next) {
+    GstUNIXRendition *rendition = walk->data;
+
+    next = walk->next;
+
+    if (gst_unix_rendition_get_n_clients (rendition) == 0) {
+      sink->renditions = g_list_delete_link (sink->renditions, walk);
+      unused = g_list_prepend (unused, rendition);
+    } else if (caps) {
+      gst_unix_rendition_push (rendition, caps,
+          &GST_BASE_SINK_CAST (sink)->segment, buf, send_time);
+    }
+  }
+  g_mutex_unlock (&sink->rendition_lock);
+
+  g_list_free_full (unused, (GDestroyNotify) gst_unix_rendition_free);
+  if (caps)
+    gst_caps_unref (caps);
+}
+
+/* hand @event to every rendition, a converter keeps state that has to be
+ * flushed or drained with the stream */
+static void
+gst_unix_server_sink_push_rendition_event (GstUNIXServerSink * sink,
+    GstEvent * event)
+{
+  GList *walk;
+
+  if (!g_atomic_pointer_get (&sink->renditions))
+    return;
+
+  g_mutex_lock (&sink->rendition_lock);
+  for (walk = sink->renditions; walk; walk = walk->next)
+    gst_unix_rendition_push_event (walk->data, gst_event_ref (event));
+  g_mutex_unlock (&sink->rendition_lock);
+}
+
+/* a rendition converts sample format, rate and channels of raw audio, the
+ * requested @caps have to match the stream in everything else */
+static gboolean
+gst_unix_server_sink_can_convert (GstUNIXServerSink * sink,
+    const GstCaps * caps)
+{
+  GstCaps *current;
+  gboolean ret = FALSE;
+  guint i;
+
+  current = gst_pad_get_current_caps (GST_BASE_SINK_PAD (sink));
+  if (!current)
+    goto done;
+
+  for (i = 0; i < gst_caps_get_size (current); i++) {
+    if (!gst_structure_has_name (gst_caps_get_structure (current, i),
+            "audio/x-raw"))
+      goto done;
+  }
+
+  current = gst_caps_make_writable (current);
+  for (i = 0; i < gst_caps_get_size (current); i++)
+    gst_structure_remove_fields (gst_caps_get_structure (current, i),
+        "format", "rate", "channels", "channel-mask", NULL);
+  ret = gst_caps_can_intersect (current, caps);
+
+done:
+  if (!ret)
+    GST_WARNING_OBJECT (sink, "cannot convert %" GST_PTR_FORMAT " to %"
+        GST_PTR_FORMAT, current, caps);
+  if (current)
+    gst_caps_unref (current);
+
+  return ret;
+}
+
+/* act on the hello of a framed client. Returns FALSE when the client should
+ * be dropped; sets @claimed when the client was handed to a stripe group or
+ * a rendition */
+static gboolean
+gst_unix_server_sink_handle_hello (GstUNIXServerSink * sink,
+    GSocket * client_socket, const GstStructure * hello, gboolean * claimed)
+{
+  guint64 group = 0;
+  guint index = 0, count = 1;
+  const gchar *rendition;
+  gboolean ret = TRUE;
+
+  *claimed = FALSE;
+
+  GST_DEBUG_OBJECT (sink, "client hello %" GST_PTR_FORMAT, hello);
+
+  gst_structure_get_uint (hello, "stripe-count", &count);
+  rendition = gst_structure_get_string (hello, "rendition");
+  if (rendition) {
+    GstCaps *caps = gst_caps_from_string (rendition);
+
+    if (!caps || !gst_caps_is_fixed (caps) || count > 1 ||
+        !gst_unix_server_sink_can_convert (sink, caps)) {
+      ret = FALSE;
+    } else {
+      ret = gst_unix_server_sink_add_rendition (sink, client_socket, caps);
+      *claimed = ret;
+    }
+    if (caps)
+      gst_caps_unref (caps);
+  } else if (count > 1 || gst_structure_has_field (hello, "stripe-group")) {
+    /* a client on a single connection may ask for a group of one stripe, to
+     * get a sender thread of its own that can splice */
+    if (!gst_structure_get_uint64 (hello, "stripe-group", &group) ||
+        !gst_structure_get_uint (hello, "stripe-index", &index) ||
+        count > GST_UNIX_PROTOCOL_MAX_STRIPES) {
+      ret = FALSE;
+    } else {
+      ret = gst_unix_server_sink_add_stripe (sink, client_socket, group,
+          index, count);
+      *claimed = ret;
+    }
+  }
+
+  return ret;
+}
+
+/* queue a ready client for the thread writing to the clients */
+static void
+gst_unix_server_sink_hand_off (GstUNIXServerSink * sink,
+    GSocket * client_socket)
+{
+  GST_OBJECT_LOCK (sink);
+  sink->accepted++;
+  GST_OBJECT_UNLOCK (sink);
+
+  gst_atomic_queue_push (sink->pending, g_object_ref (client_socket));
+  g_main_context_wakeup (sink->element.main_context);
+}
+
+static void
+gst_unix_server_sink_reject (GstUNIXServerSink * sink, GSocket * client_socket)
+{
+  g_socket_close (client_socket, NULL);
+
+  GST_OBJECT_LOCK (sink);
+  sink->rejected++;
+  GST_OBJECT_UNLOCK (sink);
+}
+
+/* called from the accept thread, or after it stopped */
+static void
+gst_unix_server_sink_free_greeting (GstUNIXGreeting * greeting)
+{
+  GstUNIXServerSink *sink = greeting->sink;
+
+  sink->greetings = g_list_remove (sink->greetings, greeting);
+
+  g_source_destroy (greeting->source);
+  g_source_unref (greeting->source);
+  g_source_destroy (greeting->timeout);
+  g_source_unref (greeting->timeout);
+  g_object_unref (greeting->socket);
+  g_free (greeting->hello);
+  g_slice_free (GstUNIXGreeting, greeting);
+}
+
+/* read as much of the hello as is available without blocking, and act on
+ * it once complete */
+static gboolean
+gst_unix_server_sink_greeting_read (GSocket * socket, GIOCondition condition,
+    GstUNIXGreeting * greeting)
+{
+  GstUNIXServerSink *sink = greeting->sink;
+  GstStructure *hello;
+  GError *err = NULL;
+  gboolean claimed;
+  gchar *data;
+  gsize size;
+  gssize ret;
+
+  if (greeting->received < sizeof (GstUNIXFrameHeader)) {
+    data = (gchar *) & greeting->header + greeting->received;
+    size = sizeof (GstUNIXFrameHeader) - greeting->received;
+  } else {
+    gsize offset = greeting->received - sizeof (GstUNIXFrameHeader);
+
+    data = greeting->hello + offset;
+    size = greeting->header.size - offset;
+  }
+
+  ret = g_socket_receive_with_blocking (socket, data, size, FALSE, NULL,
+      &err);
+  if (ret < 0) {
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+      g_clear_error (&err);
+      return G_SOURCE_CONTINUE;
+    }
+    goto failed;
+  } else if (ret == 0) {
+    g_set_error (&err, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Connection closed during handshake");
+    goto failed;
+  }
+
+  greeting->received += ret;
+  if (greeting->received < sizeof (GstUNIXFrameHeader))
+    return G_SOURCE_CONTINUE;
+
+  if (!greeting->hello) {
+    if (!gst_unix_protocol_check_hello (&greeting->header, &err))
+      goto failed;
+    greeting->hello = g_malloc (greeting->header.size);
+    return G_SOURCE_CONTINUE;
+  }
+
+  if (greeting->received < sizeof (GstUNIXFrameHeader) +
+      greeting->header.size)
+    return G_SOURCE_CONTINUE;
+
+  hello = gst_unix_protocol_parse_hello (greeting->hello,
+      greeting->header.size, &err);
+  if (!hello)
+    goto failed;
+
+  if (!gst_unix_server_sink_handle_hello (sink, socket, hello, &claimed))
+    gst_unix_server_sink_reject (sink, socket);
+  else if (!claimed)
+    gst_unix_server_sink_hand_off (sink, socket);
+  gst_structure_free (hello);
+
+  gst_unix_server_sink_free_greeting (greeting);
+
+  return G_SOURCE_REMOVE;
+
+  /* ERRORS */
+failed:
+  {
+    GST_WARNING_OBJECT (sink, "dropping client %p without hello: %s",
+        socket, err->message);
+    g_clear_error (&err);
+    gst_unix_server_sink_reject (sink, socket);
+    gst_unix_server_sink_free_greeting (greeting);
+    return G_SOURCE_REMOVE;
+  }
+}
+
+static gboolean
+gst_unix_server_sink_greeting_timeout (GstUNIXGreeting * greeting)
+{
+  GST_WARNING_OBJECT (greeting->sink, "dropping client %p without hello: "
+      "timed out", greeting->socket);
+  gst_unix_server_sink_reject (greeting->sink, greeting->socket);
+  gst_unix_server_sink_free_greeting (greeting);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* wait for the hello of a framed client without blocking the accept thread,
+ * so a client that connects and stays silent does not delay the others */
+static void
+gst_unix_server_sink_greet (GstUNIXServerSink * sink, GSocket * client_socket)
+{
+  GstUNIXGreeting *greeting;
+
+  greeting = g_slice_new0 (GstUNIXGreeting);
+  greeting->sink = sink;
+  greeting->socket = g_object_ref (client_socket);
+
+  greeting->source = g_socket_create_source (client_socket,
+      G_IO_IN | G_IO_ERR | G_IO_HUP, NULL);
+  g_source_set_callback (greeting->source,
+      (GSourceFunc) gst_unix_server_sink_greeting_read, greeting, NULL);
+  g_source_attach (greeting->source, sink->accept_context);
+
+  greeting->timeout = g_timeout_source_new_seconds (HANDSHAKE_TIMEOUT);
+  g_source_set_callback (greeting->timeout,
+      (GSourceFunc) gst_unix_server_sink_greeting_timeout, greeting, NULL);
+  g_source_attach (greeting->timeout, sink->accept_context);
+
+  sink->greetings = g_list_prepend (sink->greetings, greeting);
+}
+
+/* handle a read request on the server, which indicates a new client
+ * connection. Runs in the accept thread, the prepared client is handed to
+ * the handoff source */
+static gboolean
+gst_unix_server_sink_handle_server_read (GstUNIXServerSink * sink)
+{
+  GSocket *client_socket;
+  GError *err = NULL;
+  gint size;
 
   /* wait on server socket for connections */
   client_socket =
-      g_socket_accept (sink->server_socket, sink->element.cancellable, &err);
+      g_socket_accept (sink->server_socket, sink->accept_cancellable, &err);
   if (!client_socket)
     goto accept_failed;
 
-  handle.socket = client_socket;
-  /* gst_multi_handle_sink_add does not take ownership of client_socket */
-  gst_multi_handle_sink_add (GST_MULTI_HANDLE_SINK (sink), handle);
+  GST_UNIX_TRACE2 (accept, sink, g_socket_get_fd (client_socket));
 
-#ifndef GST_DISABLE_GST_DEBUG
-  {
-    GST_DEBUG_OBJECT (sink, "Received new client. %p", client_socket);
-  }
-#endif
+  size = gst_unix_server_sink_client_sndbuf (sink, 1);
+  if (size > 0)
+    gst_unix_server_sink_apply_sndbuf (sink, client_socket, size);
 
+  if (sink->protocol == GST_UNIX_PROTOCOL_FRAMED)
+    gst_unix_server_sink_greet (sink, client_socket);
+  else
+    gst_unix_server_sink_hand_off (sink, client_socket);
   g_object_unref (client_socket);
+
   return TRUE;
 
   /* ERRORS */
 accept_failed:
   {
+    if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED) ||
+        g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+      GST_DEBUG_OBJECT (sink, "no client to accept: %s", err->message);
+      g_clear_error (&err);
+      return TRUE;
+    }
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
         ("Could not accept client on server socket %p: %s",
             sink->server_socket, err->message));
@@ -213,6 +1464,41 @@ error:
   return FALSE;
 }
 
+static GstStructure *
+gst_unix_server_sink_get_stats (GstUNIXServerSink * sink)
+{
+  GstStructure *s;
+  GList *walk;
+  guint i;
+
+  s = gst_structure_new_empty ("GstUNIXServerSinkStats");
+
+  GST_OBJECT_LOCK (sink);
+  gst_unix_jitter_add_to_structure (&sink->io_jitter, s, "io");
+  gst_unix_jitter_add_to_structure (&sink->render_jitter, s, "render");
+  gst_structure_set (s, "clients-accepted", G_TYPE_UINT64, sink->accepted,
+      "clients-rejected", G_TYPE_UINT64, sink->rejected, NULL);
+  if (sink->trace_timing)
+    gst_unix_histogram_add_to_structure (&sink->render_time, s, "render-time");
+  gst_structure_set (s, "bitrate", G_TYPE_UINT64, sink->bitrate.rate,
+      "send-buffer-size", G_TYPE_INT, sink->sndbuf_applied, NULL);
+  gst_structure_set (s, "bytes-spliced", G_TYPE_UINT64, sink->spliced, NULL);
+  GST_OBJECT_UNLOCK (sink);
+
+  g_mutex_lock (&sink->rendition_lock);
+  gst_structure_set (s, "renditions", G_TYPE_UINT,
+      g_list_length (sink->renditions), NULL);
+  for (walk = sink->renditions, i = 0; walk; walk = walk->next, i++) {
+    gchar *prefix = g_strdup_printf ("rendition%u", i);
+
+    gst_unix_rendition_add_to_structure (walk->data, s, prefix);
+    g_free (prefix);
+  }
+  g_mutex_unlock (&sink->rendition_lock);
+
+  return s;
+}
+
 static void
 gst_unix_server_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -232,6 +1518,46 @@ gst_unix_server_sink_set_property (GObject * object, guint prop_id,
       g_free (sink->path);
       sink->path = g_strdup (g_value_get_string (value));
       break;
+    case PROP_PROTOCOL:
+      sink->protocol = g_value_get_enum (value);
+      break;
+    case PROP_SEND_TIMESTAMPS:
+      sink->send_timestamps = g_value_get_boolean (value);
+      break;
+    case PROP_TRACE_TIMING:
+      sink->trace_timing = g_value_get_boolean (value);
+      break;
+    case PROP_LATENCY_TARGET:
+      GST_OBJECT_LOCK (sink);
+      sink->latency_target = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_SEND_BUFFER_SIZE:
+      GST_OBJECT_LOCK (sink);
+      sink->send_buffer_size = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_SPLICE_THRESHOLD:
+      GST_OBJECT_LOCK (sink);
+      sink->splice_threshold = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_CPU_AFFINITY:
+      GST_OBJECT_LOCK (sink);
+      g_free (sink->thread_config.cpus);
+      sink->thread_config.cpus = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_SCHED_POLICY:
+      GST_OBJECT_LOCK (sink);
+      sink->thread_config.policy = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_SCHED_PRIORITY:
+      GST_OBJECT_LOCK (sink);
+      sink->thread_config.priority = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -251,6 +1577,39 @@ gst_unix_server_sink_get_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_PATH:
       g_value_set_string (value, sink->path);
+      break;
+    case PROP_PROTOCOL:
+      g_value_set_enum (value, sink->protocol);
+      break;
+    case PROP_CPU_AFFINITY:
+      GST_OBJECT_LOCK (sink);
+      g_value_set_string (value, sink->thread_config.cpus);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_SCHED_POLICY:
+      g_value_set_enum (value, sink->thread_config.policy);
+      break;
+    case PROP_SCHED_PRIORITY:
+      g_value_set_int (value, sink->thread_config.priority);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_unix_server_sink_get_stats (sink));
+      break;
+    case PROP_SEND_TIMESTAMPS:
+      g_value_set_boolean (value, sink->send_timestamps);
+      break;
+    case PROP_TRACE_TIMING:
+      g_value_set_boolean (value, sink->trace_timing);
+      break;
+    case PROP_LATENCY_TARGET:
+      g_value_set_uint (value, sink->latency_target);
+      break;
+    case PROP_SEND_BUFFER_SIZE:
+      g_value_set_int (value, sink->send_buffer_size);
+      break;
+    case PROP_SPLICE_THRESHOLD:
+      g_value_set_uint (value, sink->splice_threshold);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -258,7 +1617,47 @@ gst_unix_server_sink_get_property (GObject * object, guint prop_id,
 }
 
 
+static gboolean
+gst_unix_server_sink_quit_accept (GMainLoop * loop)
+{
+  g_main_loop_quit (loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+gst_unix_server_sink_accept_thread (GstUNIXServerSink * sink)
+{
+  g_main_context_push_thread_default (sink->accept_context);
+  g_main_loop_run (sink->accept_loop);
+  g_main_context_pop_thread_default (sink->accept_context);
+
+  return NULL;
+}
+
 /* create a socket for sending to remote machine */
+/* local clients lag as far as socket clients may. Limits in time cannot be
+ * checked without looking at the queued buffers, those clients only get
+ * the default byte limit */
+static void
+gst_unix_server_sink_set_local_limits (GstUNIXServerSink * sink)
+{
+  gint64 max_buffers, max_bytes = -1, units_max;
+  gint buffers_max;
+  GstFormat format;
+
+  g_object_get (sink, "buffers-max", &buffers_max, "unit-format", &format,
+      "units-max", &units_max, NULL);
+
+  max_buffers = buffers_max;
+  if (units_max > 0 && format == GST_FORMAT_BUFFERS)
+    max_buffers = max_buffers > 0 ? MIN (max_buffers, units_max) : units_max;
+  else if (units_max > 0 && format == GST_FORMAT_BYTES)
+    max_bytes = units_max;
+
+  gst_unix_local_server_set_limits (sink->local, max_buffers, max_bytes);
+}
+
 static gboolean
 gst_unix_server_sink_init_send (GstMultiHandleSink * parent)
 {
@@ -302,14 +1701,57 @@ gst_unix_server_sink_init_send (GstMultiHandleSink * parent)
 
   GST_DEBUG_OBJECT (this, "listened on server socket %p", this->server_socket);
 
+  /* clients in this process skip the socket */
+  this->local = gst_unix_local_server_new (this->path);
+  if (this->local)
+    gst_unix_server_sink_set_local_limits (this);
+
+  /* accepting and greeting clients happens in its own thread, prepared
+   * clients are added from the main context writing to the others */
+  g_cancellable_reset (this->accept_cancellable);
+  this->accept_context = g_main_context_new ();
+  this->accept_loop = g_main_loop_new (this->accept_context, FALSE);
+
+  this->handoff_source = g_source_new (&gst_unix_handoff_source_funcs,
+      sizeof (GstUNIXHandoffSource));
+  ((GstUNIXHandoffSource *) this->handoff_source)->sink = this;
+  g_source_attach (this->handoff_source, this->element.main_context);
+
   this->server_source =
       g_socket_create_source (this->server_socket,
       G_IO_IN | G_IO_OUT | G_IO_PRI | G_IO_ERR | G_IO_HUP,
-      this->element.cancellable);
+      this->accept_cancellable);
   g_source_set_callback (this->server_source,
       (GSourceFunc) gst_unix_server_sink_socket_condition, gst_object_ref (this),
       (GDestroyNotify) gst_object_unref);
-  g_source_attach (this->server_source, this->element.main_context);
+  g_source_attach (this->server_source, this->accept_context);
+
+  this->sweep_source = g_timeout_source_new_seconds (1);
+  g_source_set_callback (this->sweep_source,
+      (GSourceFunc) gst_unix_server_sink_sweep_groups, this, NULL);
+  g_source_attach (this->sweep_source, this->accept_context);
+
+  this->accept_thread = g_thread_new ("unixserversink-accept",
+      (GThreadFunc) gst_unix_server_sink_accept_thread, this);
+
+  GST_OBJECT_LOCK (this);
+  gst_unix_jitter_reset (&this->io_jitter);
+  gst_unix_jitter_reset (&this->render_jitter);
+  this->accepted = 0;
+  this->rejected = 0;
+  gst_unix_histogram_reset (&this->render_time);
+  gst_unix_bitrate_reset (&this->bitrate);
+  this->sndbuf = 0;
+  this->sndbuf_applied = 0;
+  this->sndbuf_clamped = FALSE;
+  this->spliced = 0;
+  GST_OBJECT_UNLOCK (this);
+
+  this->io_source = g_source_new (&gst_unix_io_source_funcs,
+      sizeof (GstUNIXIOSource));
+  ((GstUNIXIOSource *) this->io_source)->sink = this;
+  ((GstUNIXIOSource *) this->io_source)->configured = FALSE;
+  g_source_attach (this->io_source, this->element.main_context);
 
   return TRUE;
 
@@ -353,6 +1795,72 @@ static gboolean
 gst_unix_server_sink_close (GstMultiHandleSink * parent)
 {
   GstUNIXServerSink *this = GST_UNIX_SERVER_SINK (parent);
+  GSocket *client_socket;
+  GList *groups;
+
+  /* stop accepting first, clients still sending their hello are dropped */
+  if (this->accept_thread) {
+    GSource *source;
+
+    g_cancellable_cancel (this->accept_cancellable);
+    /* quit from inside the loop, a g_main_loop_quit() before the thread
+     * got to g_main_loop_run() would be lost */
+    source = g_idle_source_new ();
+    g_source_set_callback (source,
+        (GSourceFunc) gst_unix_server_sink_quit_accept,
+        g_main_loop_ref (this->accept_loop), (GDestroyNotify) g_main_loop_unref);
+    g_source_attach (source, this->accept_context);
+    g_source_unref (source);
+    g_thread_join (this->accept_thread);
+    this->accept_thread = NULL;
+  }
+  while (this->greetings) {
+    GstUNIXGreeting *greeting = this->greetings->data;
+
+    g_socket_close (greeting->socket, NULL);
+    gst_unix_server_sink_free_greeting (greeting);
+  }
+
+  if (this->handoff_source) {
+    g_source_destroy (this->handoff_source);
+    g_source_unref (this->handoff_source);
+    this->handoff_source = NULL;
+  }
+  while ((client_socket = gst_atomic_queue_pop (this->pending))) {
+    g_socket_close (client_socket, NULL);
+    g_object_unref (client_socket);
+  }
+
+  g_mutex_lock (&this->stripe_lock);
+  groups = this->stripe_groups;
+  this->stripe_groups = NULL;
+  g_mutex_unlock (&this->stripe_lock);
+  g_list_free_full (groups, (GDestroyNotify) gst_unix_server_sink_free_group);
+
+  g_mutex_lock (&this->rendition_lock);
+  groups = this->renditions;
+  this->renditions = NULL;
+  g_mutex_unlock (&this->rendition_lock);
+  g_list_free_full (groups, (GDestroyNotify) gst_unix_rendition_free);
+
+  this->seq = 0;
+
+  if (this->local) {
+    gst_unix_local_server_free (this->local);
+    this->local = NULL;
+  }
+
+  if (this->io_source) {
+    g_source_destroy (this->io_source);
+    g_source_unref (this->io_source);
+    this->io_source = NULL;
+  }
+
+  if (this->sweep_source) {
+    g_source_destroy (this->sweep_source);
+    g_source_unref (this->sweep_source);
+    this->sweep_source = NULL;
+  }
 
   if (this->server_source) {
     GST_DEBUG_OBJECT (this, "destroying server_source");
@@ -362,6 +1870,15 @@ gst_unix_server_sink_close (GstMultiHandleSink * parent)
     this->server_source = NULL;
   }
 
+  if (this->accept_loop) {
+    g_main_loop_unref (this->accept_loop);
+    this->accept_loop = NULL;
+  }
+  if (this->accept_context) {
+    g_main_context_unref (this->accept_context);
+    this->accept_context = NULL;
+  }
+
   if (this->server_socket) {
     GError *err = NULL;
 
@@ -31,6 +31,11 @@
 G_BEGIN_DECLS
 
 #include "gstmultisocketsink.h"
+#include "gstunixprotocol.h"
+#include "gstunixthread.h"
+#include "gstunixlocal.h"
+#include "gstunixlatency.h"
+#include "gstunixsockbuf.h"
 
 #define UNIX_DEFAULT_PATH "/tmp/gst-unix.sock"
 
@@ -47,6 +52,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstUNIXServerSink GstUNIXServerSink;
 typedef struct _GstUNIXServerSinkClass GstUNIXServerSinkClass;
+typedef struct _GstUNIXStripeGroup GstUNIXStripeGroup;
 
 typedef enum {
   GST_UNIX_SERVER_SINK_OPEN             = (GST_ELEMENT_FLAG_LAST << 0),
@@ -67,6 +73,57 @@ struct _GstUNIXServerSink {
 
   GSocket *server_socket;
   GSource *server_source;
+
+  /* client acceptance, server_source runs in the accept thread */
+  GMainContext *accept_context;
+  GMainLoop *accept_loop;
+  GThread *accept_thread;
+  GCancellable *accept_cancellable;
+  GList *greetings;             /* clients sending their hello, only used
+                                 * from the accept thread */
+  GstAtomicQueue *pending;      /* prepared client GSockets */
+  GSource *handoff_source;
+  GSource *sweep_source;        /* drops incomplete stripe groups */
+  guint64 accepted;             /* protected by the object lock */
+  guint64 rejected;             /* protected by the object lock */
+
+  GstUNIXProtocol protocol;
+  guint64 seq;
+  gboolean send_timestamps;
+
+  /* clients in this process */
+  GstUNIXLocalServer *local;
+
+  /* striped clients, protected by stripe_lock */
+  GMutex stripe_lock;
+  GCond stripe_cond;
+  GList *stripe_groups;
+
+  /* converted renditions, protected by rendition_lock */
+  GMutex rendition_lock;
+  GList *renditions;
+
+  /* I/O thread placement */
+  GstUNIXThreadConfig thread_config;
+  GSource *io_source;
+  GstUNIXJitter io_jitter;
+  GstUNIXJitter render_jitter;
+
+  /* timing breakdown, protected by the object lock */
+  gboolean trace_timing;
+  GstUNIXHistogram render_time;
+
+  /* socket buffer sizing, protected by the object lock */
+  guint latency_target;
+  gint send_buffer_size;
+  gint sndbuf;
+  gint sndbuf_applied;          /* granted by the kernel */
+  gboolean sndbuf_clamped;
+  GstUNIXBitrate bitrate;
+
+  /* zero-copy send of large payloads, protected by the object lock */
+  guint splice_threshold;
+  guint64 spliced;
 };
 
 struct _GstUNIXServerSinkClass {
@@ -0,0 +1,141 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Socket buffer sizing. The kernel defaults are too small for raw video and
+ * hide hundreds of milliseconds of latency for audio; with a latency target
+ * the buffers are sized to hold that much of the measured bitrate.
+ *
+ * Queued data of a UNIX stream socket is charged to the sending socket, so
+ * SO_SNDBUF on the server is what bounds the latency on Linux; SO_RCVBUF on
+ * the client only matters on other systems.
+ *
+ * Linux doubles whatever is set to leave room for its bookkeeping, and
+ * charges every queued skb with its truesize, which for large writes is
+ * little more than the payload. Setting the wanted size unchanged would let
+ * close to twice the latency target queue up, so only half is asked for. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "gstunixsockbuf.h"
+#include "gstunixlatency.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+void
+gst_unix_bitrate_reset (GstUNIXBitrate * bitrate)
+{
+  memset (bitrate, 0, sizeof (GstUNIXBitrate));
+  bitrate->start = GST_CLOCK_TIME_NONE;
+}
+
+/* account @bytes sent or received now. Returns TRUE when a window ended
+ * and the rate was updated */
+gboolean
+gst_unix_bitrate_update (GstUNIXBitrate * bitrate, gsize bytes)
+{
+  GstClockTime now = gst_unix_latency_now (), elapsed;
+  guint64 rate;
+
+  if (G_UNLIKELY (!GST_CLOCK_TIME_IS_VALID (bitrate->start))) {
+    bitrate->start = now;
+    bitrate->bytes = bytes;
+    return FALSE;
+  }
+
+  elapsed = now - bitrate->start;
+  if (elapsed < GST_UNIX_BITRATE_WINDOW) {
+    bitrate->bytes += bytes;
+    return FALSE;
+  }
+
+  rate = gst_util_uint64_scale (bitrate->bytes, GST_SECOND, elapsed);
+  bitrate->rate = bitrate->rate ? (3 * bitrate->rate + rate) / 4 : rate;
+  bitrate->start = now;
+  bitrate->bytes = bytes;
+
+  return TRUE;
+}
+
+/* buffer size holding @latency worth of @rate bytes per second */
+gint
+gst_unix_sockbuf_size_for (guint64 rate, GstClockTime latency)
+{
+  guint64 size = gst_util_uint64_scale (rate, latency, GST_SECOND);
+
+  return CLAMP (size, GST_UNIX_SOCKBUF_MIN, GST_UNIX_SOCKBUF_MAX);
+}
+
+/* only resize for changes of more than a quarter, so a rate wobbling around
+ * does not make us call setsockopt for every window */
+gboolean
+gst_unix_sockbuf_differs (gint current, gint wanted)
+{
+  return current <= 0 || ABS (wanted - current) > current / 4;
+}
+
+/* whether the kernel granted less than @wanted bytes, as Linux does above
+ * net.core.wmem_max and rmem_max. Odd sizes come back a byte short after
+ * halving and doubling */
+gboolean
+gst_unix_sockbuf_clamped (gint wanted, gint applied)
+{
+  return applied >= 0 && applied < (wanted & ~1);
+}
+
+/* set SO_SNDBUF or SO_RCVBUF so about @size bytes can be queued. Returns
+ * the size the kernel actually uses, which may be larger, or -1 */
+gint
+gst_unix_socket_set_buffer_size (GSocket * socket, gboolean send, gint size)
+{
+  gint option = send ? SO_SNDBUF : SO_RCVBUF;
+
+#ifdef __linux__
+  size /= 2;
+#endif
+
+  if (setsockopt (g_socket_get_fd (socket), SOL_SOCKET, option, &size,
+          sizeof (size)) < 0) {
+    GST_WARNING ("failed to set %s of socket %p to %d: %s",
+        send ? "SO_SNDBUF" : "SO_RCVBUF", socket, size, g_strerror (errno));
+    return -1;
+  }
+
+  return gst_unix_socket_get_buffer_size (socket, send);
+}
+
+gint
+gst_unix_socket_get_buffer_size (GSocket * socket, gboolean send)
+{
+  gint size = -1;
+  socklen_t len = sizeof (size);
+
+  if (getsockopt (g_socket_get_fd (socket), SOL_SOCKET,
+          send ? SO_SNDBUF : SO_RCVBUF, &size, &len) < 0)
+    return -1;
+
+  return size;
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_SOCKBUF_H__
+#define __GST_UNIX_SOCKBUF_H__
+
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* bounds for sizes derived from a latency target */
+#define GST_UNIX_SOCKBUF_MIN            (4 * 1024)
+#define GST_UNIX_SOCKBUF_MAX            (16 * 1024 * 1024)
+
+/* bytes are counted over windows of this length */
+#define GST_UNIX_BITRATE_WINDOW         (250 * GST_MSECOND)
+
+typedef struct _GstUNIXBitrate GstUNIXBitrate;
+
+/**
+ * GstUNIXBitrate:
+ * @rate: smoothed rate in bytes per second, 0 until the first window ended
+ *
+ * Bitrate estimate of a stream, updated with every buffer.
+ */
+struct _GstUNIXBitrate {
+  GstClockTime start;
+  guint64 bytes;
+  guint64 rate;
+};
+
+void     gst_unix_bitrate_reset          (GstUNIXBitrate * bitrate);
+gboolean gst_unix_bitrate_update         (GstUNIXBitrate * bitrate,
+                                          gsize bytes);
+
+gint     gst_unix_sockbuf_size_for       (guint64 rate, GstClockTime latency);
+gboolean gst_unix_sockbuf_differs        (gint current, gint wanted);
+gboolean gst_unix_sockbuf_clamped        (gint wanted, gint applied);
+
+gint     gst_unix_socket_set_buffer_size (GSocket * socket, gboolean send,
+                                          gint size);
+gint     gst_unix_socket_get_buffer_size (GSocket * socket, gboolean send);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_SOCKBUF_H__ */
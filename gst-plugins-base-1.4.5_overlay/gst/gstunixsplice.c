@@ -0,0 +1,289 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Zero-copy send path for large payloads. The payload pages are moved into
+ * a pipe with vmsplice() and from there spliced into the socket, so the
+ * kernel references the pages of the GstBuffer instead of copying them
+ * into the socket buffer.
+ *
+ * The pages stay referenced by the queued socket data until the peer has
+ * read it, so the buffer (and its mapping) must neither be freed nor
+ * reused before. Every sent buffer is kept in an in-flight list together
+ * with the number of bytes written to the socket up to its end; a buffer is
+ * released once SIOCOUTQ shows the socket queue shrank below that. The
+ * queue length counts kernel overhead too, so this errs on the side of
+ * releasing late. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/sockios.h>
+#endif
+
+#include "gstunixsplice.h"
+#include "gstunixprotocol.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+typedef struct
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  guint64 end;                  /* bytes written to the socket up to the
+                                 * end of this buffer */
+} GstUNIXSpliceRef;
+
+struct _GstUNIXSplice
+{
+  GSocket *socket;
+  gint pipe[2];
+  gsize pipe_size;
+  guint64 sent;                 /* bytes written to the socket so far */
+  GQueue in_flight;             /* GstUNIXSpliceRef, oldest first */
+};
+
+static void
+gst_unix_splice_ref_free (GstUNIXSpliceRef * ref)
+{
+  gst_buffer_unmap (ref->buffer, &ref->map);
+  gst_buffer_unref (ref->buffer);
+  g_slice_free (GstUNIXSpliceRef, ref);
+}
+
+/* bytes written to the socket that the peer did not read yet, -1 when
+ * unknown */
+static gint64
+gst_unix_splice_queued (GstUNIXSplice * sp)
+{
+#ifdef __linux__
+  gint queued;
+
+  if (ioctl (g_socket_get_fd (sp->socket), SIOCOUTQ, &queued) == 0)
+    return queued;
+#endif
+  return -1;
+}
+
+/* release the buffers the peer has read completely */
+static void
+gst_unix_splice_reap (GstUNIXSplice * sp)
+{
+  GstUNIXSpliceRef *ref;
+  gint64 queued;
+  guint64 done;
+
+  if (g_queue_is_empty (&sp->in_flight))
+    return;
+
+  queued = gst_unix_splice_queued (sp);
+  if (queued < 0)
+    return;
+
+  done = sp->sent > (guint64) queued ? sp->sent - queued : 0;
+  while ((ref = g_queue_peek_head (&sp->in_flight)) && ref->end <= done) {
+    g_queue_pop_head (&sp->in_flight);
+    gst_unix_splice_ref_free (ref);
+  }
+}
+
+GstUNIXSplice *
+gst_unix_splice_new (GSocket * socket, GError ** error)
+{
+#ifdef __linux__
+  GstUNIXSplice *sp;
+  gint fds[2], size;
+
+  if (pipe2 (fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+    gint errsv = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+        "Could not create pipe: %s", g_strerror (errsv));
+    return NULL;
+  }
+
+  /* a larger pipe means fewer round trips per buffer; the limit for
+   * unprivileged processes may refuse it, the default is still usable */
+  fcntl (fds[1], F_SETPIPE_SZ, GST_UNIX_SPLICE_PIPE_SIZE);
+  size = fcntl (fds[1], F_GETPIPE_SZ);
+
+  sp = g_slice_new0 (GstUNIXSplice);
+  sp->socket = g_object_ref (socket);
+  sp->pipe[0] = fds[0];
+  sp->pipe[1] = fds[1];
+  sp->pipe_size = size > 0 ? size : 64 * 1024;
+  g_queue_init (&sp->in_flight);
+
+  GST_DEBUG ("splicing into socket %p through a %" G_GSIZE_FORMAT
+      " bytes pipe", socket, sp->pipe_size);
+
+  return sp;
+#else
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+      "splice is not supported on this platform");
+  return NULL;
+#endif
+}
+
+/* close the pipe and release all buffers. With @drain, first wait up to
+ * GST_UNIX_SPLICE_DRAIN_TIMEOUT for the peer to read them; without, the
+ * connection is known to be going away */
+void
+gst_unix_splice_free (GstUNIXSplice * sp, gboolean drain)
+{
+  gint64 deadline;
+
+  deadline = g_get_monotonic_time () + GST_UNIX_SPLICE_DRAIN_TIMEOUT;
+  gst_unix_splice_reap (sp);
+  while (drain && !g_queue_is_empty (&sp->in_flight) &&
+      g_get_monotonic_time () < deadline) {
+    g_usleep (1000);
+    gst_unix_splice_reap (sp);
+  }
+
+  if (!g_queue_is_empty (&sp->in_flight))
+    GST_WARNING ("releasing %u buffers the peer of socket %p did not read",
+        g_queue_get_length (&sp->in_flight), sp->socket);
+
+  g_queue_foreach (&sp->in_flight, (GFunc) gst_unix_splice_ref_free,
+      NULL);
+  g_queue_clear (&sp->in_flight);
+  close (sp->pipe[0]);
+  close (sp->pipe[1]);
+  g_object_unref (sp->socket);
+  g_slice_free (GstUNIXSplice, sp);
+}
+
+#ifdef __linux__
+/* move @size bytes from the pipe into the socket */
+static gboolean
+gst_unix_splice_out (GstUNIXSplice * sp, gsize size,
+    GCancellable * cancellable, GError ** error)
+{
+  gint fd = g_socket_get_fd (sp->socket);
+
+  while (size > 0) {
+    gssize ret;
+
+    ret = splice (sp->pipe[0], NULL, fd, NULL, size,
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (ret < 0) {
+      gint errsv = errno;
+
+      if (errsv == EINTR)
+        continue;
+      if (errsv == EAGAIN) {
+        /* socket buffer full */
+        if (!g_socket_condition_wait (sp->socket, G_IO_OUT, cancellable,
+                error))
+          return FALSE;
+        continue;
+      }
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+          "Could not splice into socket: %s", g_strerror (errsv));
+      return FALSE;
+    }
+    size -= ret;
+    sp->sent += ret;
+  }
+
+  return TRUE;
+}
+#endif
+
+/* write @header by copying it, then @size bytes of @buffer starting at
+ * @offset without copying. @buffer is kept alive until the peer read them */
+gboolean
+gst_unix_splice_send (GstUNIXSplice * sp, gconstpointer header,
+    gsize header_size, GstBuffer * buffer, gsize offset, gsize size,
+    GCancellable * cancellable, GError ** error)
+{
+#ifdef __linux__
+  GstUNIXSpliceRef *ref;
+  GOutputVector vector;
+  guint8 *data;
+  gboolean ret = TRUE;
+
+  vector.buffer = header;
+  vector.size = header_size;
+  if (!gst_unix_socket_send_all (sp->socket, &vector, 1, cancellable,
+          error))
+    return FALSE;
+  sp->sent += header_size;
+
+  ref = g_slice_new (GstUNIXSpliceRef);
+  if (!gst_buffer_map (buffer, &ref->map, GST_MAP_READ)) {
+    g_slice_free (GstUNIXSpliceRef, ref);
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+        "Could not map buffer");
+    return FALSE;
+  }
+  ref->buffer = gst_buffer_ref (buffer);
+
+  data = ref->map.data + offset;
+  while (size > 0) {
+    struct iovec iov;
+    gssize moved;
+
+    /* the pipe is empty here, everything up to its size fits */
+    iov.iov_base = data;
+    iov.iov_len = MIN (size, sp->pipe_size);
+    moved = vmsplice (sp->pipe[1], &iov, 1, SPLICE_F_NONBLOCK);
+    if (moved < 0) {
+      gint errsv = errno;
+
+      if (errsv == EINTR)
+        continue;
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+          "Could not vmsplice into pipe: %s", g_strerror (errsv));
+      ret = FALSE;
+      break;
+    }
+    if (!gst_unix_splice_out (sp, moved, cancellable, error)) {
+      ret = FALSE;
+      break;
+    }
+    data += moved;
+    size -= moved;
+  }
+
+  /* even after a failure part of the buffer may be queued on the socket */
+  ref->end = sp->sent;
+  g_queue_push_tail (&sp->in_flight, ref);
+  gst_unix_splice_reap (sp);
+
+  return ret;
+#else
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+      "splice is not supported on this platform");
+  return FALSE;
+#endif
+}
@@ -0,0 +1,51 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_SPLICE_H__
+#define __GST_UNIX_SPLICE_H__
+
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* capacity asked for the pipe between vmsplice and splice */
+#define GST_UNIX_SPLICE_PIPE_SIZE       (1024 * 1024)
+
+/* how long closing waits for the peer to read what is still in flight */
+#define GST_UNIX_SPLICE_DRAIN_TIMEOUT   (G_USEC_PER_SEC / 2)
+
+typedef struct _GstUNIXSplice GstUNIXSplice;
+
+GstUNIXSplice *gst_unix_splice_new      (GSocket * socket, GError ** error);
+void           gst_unix_splice_free     (GstUNIXSplice * sp,
+                                         gboolean drain);
+
+gboolean       gst_unix_splice_send     (GstUNIXSplice * sp,
+                                         gconstpointer header,
+                                         gsize header_size,
+                                         GstBuffer * buffer, gsize offset,
+                                         gsize size,
+                                         GCancellable * cancellable,
+                                         GError ** error);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_SPLICE_H__ */
@@ -0,0 +1,348 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Placement of the UNIX transport I/O threads: CPU affinity, real-time
+ * scheduling class and NUMA memory policy, plus wakeup jitter statistics
+ * to check whether it helped. Everything here acts on the calling thread,
+ * GstUNIXTaskPool gives a task threads of its own to act on. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "gstunixthread.h"
+#include "gsttcp.h"
+
+#define GST_CAT_DEFAULT tcp_debug
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+GType
+gst_unix_sched_policy_get_type (void)
+{
+  static GType unix_sched_policy_type = 0;
+  static const GEnumValue unix_sched_policy[] = {
+    {GST_UNIX_SCHED_POLICY_OTHER, "Default scheduling", "other"},
+    {GST_UNIX_SCHED_POLICY_FIFO, "SCHED_FIFO", "fifo"},
+    {GST_UNIX_SCHED_POLICY_RR, "SCHED_RR", "rr"},
+    {0, NULL, NULL},
+  };
+
+  if (!unix_sched_policy_type) {
+    unix_sched_policy_type =
+        g_enum_register_static ("GstUNIXSchedPolicy", unix_sched_policy);
+  }
+  return unix_sched_policy_type;
+}
+
+#ifdef __linux__
+/* parse a CPU list like "0-3,8,10-11" */
+static gboolean
+gst_unix_thread_parse_cpus (const gchar * cpus, cpu_set_t * set)
+{
+  gchar **ranges;
+  gboolean ret = TRUE;
+  guint i;
+
+  CPU_ZERO (set);
+
+  ranges = g_strsplit (cpus, ",", -1);
+  for (i = 0; ranges[i] && ret; i++) {
+    gchar *end;
+    guint64 first, last;
+
+    first = g_ascii_strtoull (ranges[i], &end, 10);
+    if (end == ranges[i]) {
+      ret = FALSE;
+      break;
+    }
+    last = first;
+    if (*end == '-')
+      last = g_ascii_strtoull (end + 1, &end, 10);
+    if (*end != '\0' || last < first || last >= CPU_SETSIZE) {
+      ret = FALSE;
+      break;
+    }
+    for (; first <= last; first++)
+      CPU_SET (first, set);
+  }
+  g_strfreev (ranges);
+
+  return ret && CPU_COUNT (set) > 0;
+}
+
+/* prefer memory from the node of the CPU we are running on now */
+static void
+gst_unix_thread_prefer_local_node (GstObject * object)
+{
+#if defined(SYS_getcpu) && defined(SYS_set_mempolicy)
+  unsigned int cpu, node;
+  unsigned long nodemask;
+
+  /* let the new affinity take effect */
+  sched_yield ();
+
+  if (syscall (SYS_getcpu, &cpu, &node, NULL) != 0 ||
+      node >= sizeof (nodemask) * 8)
+    return;
+
+  nodemask = 1UL << node;
+  if (syscall (SYS_set_mempolicy, MPOL_PREFERRED, &nodemask,
+          sizeof (nodemask) * 8) != 0) {
+    GST_WARNING_OBJECT (object, "failed to prefer NUMA node %u: %s", node,
+        g_strerror (errno));
+    return;
+  }
+  GST_DEBUG_OBJECT (object, "running on cpu %u, preferring NUMA node %u",
+      cpu, node);
+#endif
+}
+#endif
+
+/* apply @config to the calling thread. Failures are logged and reported,
+ * the thread keeps running with whatever could be applied */
+gboolean
+gst_unix_thread_config_apply (const GstUNIXThreadConfig * config,
+    GstObject * object)
+{
+  gboolean ret = TRUE;
+
+#ifdef __linux__
+  if (config->cpus && *config->cpus) {
+    cpu_set_t set;
+    int res;
+
+    if (!gst_unix_thread_parse_cpus (config->cpus, &set)) {
+      GST_WARNING_OBJECT (object, "invalid cpu list '%s'", config->cpus);
+      ret = FALSE;
+    } else if ((res = pthread_setaffinity_np (pthread_self (),
+                sizeof (set), &set)) != 0) {
+      GST_WARNING_OBJECT (object, "failed to pin thread to cpus %s: %s",
+          config->cpus, g_strerror (res));
+      ret = FALSE;
+    } else {
+      GST_DEBUG_OBJECT (object, "pinned thread to cpus %s", config->cpus);
+      gst_unix_thread_prefer_local_node (object);
+    }
+  }
+#else
+  if (config->cpus && *config->cpus) {
+    GST_WARNING_OBJECT (object, "cpu affinity not supported");
+    ret = FALSE;
+  }
+#endif
+
+  if (config->policy != GST_UNIX_SCHED_POLICY_OTHER) {
+    struct sched_param param;
+    int policy, res;
+
+    policy = config->policy == GST_UNIX_SCHED_POLICY_FIFO ?
+        SCHED_FIFO : SCHED_RR;
+    memset (&param, 0, sizeof (param));
+    param.sched_priority = CLAMP (config->priority,
+        sched_get_priority_min (policy), sched_get_priority_max (policy));
+
+    if ((res = pthread_setschedparam (pthread_self (), policy, &param)) != 0) {
+      GST_WARNING_OBJECT (object, "failed to set real-time priority %d: %s",
+          param.sched_priority, g_strerror (res));
+      ret = FALSE;
+    } else {
+      GST_DEBUG_OBJECT (object, "real-time priority %d",
+          param.sched_priority);
+    }
+  }
+
+  return ret;
+}
+
+typedef struct
+{
+  GstUNIXTaskPool *pool;
+  GstTaskPoolFunction func;
+  gpointer user_data;
+} GstUNIXTaskPoolJob;
+
+G_DEFINE_TYPE (GstUNIXTaskPool, gst_unix_task_pool, GST_TYPE_TASK_POOL);
+
+static gpointer
+gst_unix_task_pool_thread (GstUNIXTaskPoolJob * job)
+{
+  GstUNIXTaskPool *pool = job->pool;
+
+  if (pool->enter)
+    pool->enter (pool->user_data, NULL);
+  job->func (job->user_data);
+
+  gst_object_unref (pool);
+  g_slice_free (GstUNIXTaskPoolJob, job);
+
+  return NULL;
+}
+
+/* nothing to set up, every task gets a thread of its own */
+static void
+gst_unix_task_pool_prepare (GstTaskPool * pool, GError ** error)
+{
+}
+
+static void
+gst_unix_task_pool_cleanup (GstTaskPool * pool)
+{
+}
+
+static gpointer
+gst_unix_task_pool_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstUNIXTaskPoolJob *job;
+  GThread *thread;
+
+  job = g_slice_new (GstUNIXTaskPoolJob);
+  job->pool = gst_object_ref (pool);
+  job->func = func;
+  job->user_data = user_data;
+
+  thread = g_thread_try_new ("unixtask",
+      (GThreadFunc) gst_unix_task_pool_thread, job, error);
+  if (!thread) {
+    gst_object_unref (pool);
+    g_slice_free (GstUNIXTaskPoolJob, job);
+  }
+
+  return thread;
+}
+
+static void
+gst_unix_task_pool_join (GstTaskPool * pool, gpointer id)
+{
+  g_thread_join ((GThread *) id);
+}
+
+static void
+gst_unix_task_pool_class_init (GstUNIXTaskPoolClass * klass)
+{
+  GstTaskPoolClass *task_pool_class = (GstTaskPoolClass *) klass;
+
+  task_pool_class->prepare = gst_unix_task_pool_prepare;
+  task_pool_class->cleanup = gst_unix_task_pool_cleanup;
+  task_pool_class->push = gst_unix_task_pool_push;
+  task_pool_class->join = gst_unix_task_pool_join;
+}
+
+static void
+gst_unix_task_pool_init (GstUNIXTaskPool * pool)
+{
+}
+
+/* a pool whose threads call @enter with @user_data before running their
+ * task, to configure themselves */
+GstTaskPool *
+gst_unix_task_pool_new (GFunc enter, gpointer user_data)
+{
+  GstUNIXTaskPool *pool;
+
+  pool = g_object_new (GST_TYPE_UNIX_TASK_POOL, NULL);
+  pool->enter = enter;
+  pool->user_data = user_data;
+
+  return GST_TASK_POOL_CAST (pool);
+}
+
+void
+gst_unix_jitter_reset (GstUNIXJitter * jitter)
+{
+  memset (jitter, 0, sizeof (GstUNIXJitter));
+  jitter->last = GST_CLOCK_TIME_NONE;
+  jitter->last_interval = GST_CLOCK_TIME_NONE;
+  jitter->min_interval = GST_CLOCK_TIME_NONE;
+}
+
+/* record a wakeup of the calling thread */
+void
+gst_unix_jitter_update (GstUNIXJitter * jitter)
+{
+  GstClockTime now, interval;
+
+  now = g_get_monotonic_time () * GST_USECOND;
+  jitter->wakeups++;
+
+  if (GST_CLOCK_TIME_IS_VALID (jitter->last)) {
+    interval = now - jitter->last;
+    jitter->total += interval;
+    jitter->min_interval = MIN (jitter->min_interval, interval);
+    jitter->max_interval = MAX (jitter->max_interval, interval);
+
+    if (GST_CLOCK_TIME_IS_VALID (jitter->last_interval)) {
+      GstClockTime d = interval > jitter->last_interval ?
+          interval - jitter->last_interval : jitter->last_interval - interval;
+
+      jitter->jitter += ((gdouble) d - jitter->jitter) / 16.0;
+      jitter->max_jitter = MAX (jitter->max_jitter, d);
+    }
+    jitter->last_interval = interval;
+  }
+  jitter->last = now;
+}
+
+void
+gst_unix_jitter_add_to_structure (const GstUNIXJitter * jitter,
+    GstStructure * s, const gchar * prefix)
+{
+  gchar *wakeups, *min, *max, *mean, *cur, *peak;
+  guint64 intervals = jitter->wakeups > 1 ? jitter->wakeups - 1 : 0;
+
+  wakeups = g_strdup_printf ("%s-wakeups", prefix);
+  min = g_strdup_printf ("%s-min-interval", prefix);
+  max = g_strdup_printf ("%s-max-interval", prefix);
+  mean = g_strdup_printf ("%s-mean-interval", prefix);
+  cur = g_strdup_printf ("%s-jitter", prefix);
+  peak = g_strdup_printf ("%s-max-jitter", prefix);
+
+  gst_structure_set (s,
+      wakeups, G_TYPE_UINT64, jitter->wakeups,
+      min, G_TYPE_UINT64, intervals ? jitter->min_interval : 0,
+      max, G_TYPE_UINT64, jitter->max_interval,
+      mean, G_TYPE_UINT64, intervals ? jitter->total / intervals : 0,
+      cur, G_TYPE_UINT64, (guint64) jitter->jitter,
+      peak, G_TYPE_UINT64, jitter->max_jitter, NULL);
+
+  g_free (wakeups);
+  g_free (min);
+  g_free (max);
+  g_free (mean);
+  g_free (cur);
+  g_free (peak);
+}
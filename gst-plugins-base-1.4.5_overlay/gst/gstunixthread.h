@@ -0,0 +1,123 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_THREAD_H__
+#define __GST_UNIX_THREAD_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_UNIX_SCHED_POLICY (gst_unix_sched_policy_get_type())
+
+/**
+ * GstUNIXSchedPolicy:
+ * @GST_UNIX_SCHED_POLICY_OTHER: leave the scheduling class alone
+ * @GST_UNIX_SCHED_POLICY_FIFO: SCHED_FIFO
+ * @GST_UNIX_SCHED_POLICY_RR: SCHED_RR
+ *
+ * Scheduling class requested for the I/O threads.
+ */
+typedef enum {
+  GST_UNIX_SCHED_POLICY_OTHER,
+  GST_UNIX_SCHED_POLICY_FIFO,
+  GST_UNIX_SCHED_POLICY_RR
+} GstUNIXSchedPolicy;
+
+typedef struct _GstUNIXThreadConfig GstUNIXThreadConfig;
+typedef struct _GstUNIXJitter GstUNIXJitter;
+
+/**
+ * GstUNIXThreadConfig:
+ * @cpus: CPU list like "0-3,8", NULL or empty to not pin
+ * @policy: scheduling class
+ * @priority: real-time priority for FIFO and RR
+ *
+ * Placement of an I/O thread. When @cpus is set, the thread also prefers
+ * memory from the NUMA node of the CPU it ends up running on.
+ */
+struct _GstUNIXThreadConfig {
+  gchar *cpus;
+  GstUNIXSchedPolicy policy;
+  gint priority;
+};
+
+/**
+ * GstUNIXJitter:
+ *
+ * Wakeup interval statistics of one thread. The jitter is the smoothed
+ * difference between consecutive intervals, as in RFC 3550.
+ */
+struct _GstUNIXJitter {
+  GstClockTime last;
+  GstClockTime last_interval;
+  guint64 wakeups;
+  GstClockTime min_interval;
+  GstClockTime max_interval;
+  GstClockTime total;
+  gdouble jitter;
+  GstClockTime max_jitter;
+};
+
+#define GST_TYPE_UNIX_TASK_POOL \
+  (gst_unix_task_pool_get_type())
+#define GST_UNIX_TASK_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_UNIX_TASK_POOL,GstUNIXTaskPool))
+#define GST_IS_UNIX_TASK_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_UNIX_TASK_POOL))
+
+typedef struct _GstUNIXTaskPool GstUNIXTaskPool;
+typedef struct _GstUNIXTaskPoolClass GstUNIXTaskPoolClass;
+
+/**
+ * GstUNIXTaskPool:
+ *
+ * Task pool starting a new thread for every task and letting it exit when
+ * the task stops. Threads configured with gst_unix_thread_config_apply()
+ * are never handed to other tasks, as the threads of the default pool are.
+ */
+struct _GstUNIXTaskPool {
+  GstTaskPool parent;
+
+  GFunc enter;
+  gpointer user_data;
+};
+
+struct _GstUNIXTaskPoolClass {
+  GstTaskPoolClass parent_class;
+};
+
+GType    gst_unix_sched_policy_get_type (void);
+GType    gst_unix_task_pool_get_type    (void);
+
+GstTaskPool * gst_unix_task_pool_new    (GFunc enter, gpointer user_data);
+
+gboolean gst_unix_thread_config_apply   (const GstUNIXThreadConfig * config,
+                                         GstObject * object);
+
+void     gst_unix_jitter_reset          (GstUNIXJitter * jitter);
+void     gst_unix_jitter_update         (GstUNIXJitter * jitter);
+void     gst_unix_jitter_add_to_structure (const GstUNIXJitter * jitter,
+                                         GstStructure * s,
+                                         const gchar * prefix);
+
+G_END_DECLS
+
+#endif /* __GST_UNIX_THREAD_H__ */
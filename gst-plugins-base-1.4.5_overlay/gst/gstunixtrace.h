@@ -0,0 +1,57 @@
+/* GStreamer
+ * Copyright (C) <2015> Stefan Junker <code at stefanjunker dot de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_UNIX_TRACE_H__
+#define __GST_UNIX_TRACE_H__
+
+#include <glib.h>
+
+/* Static tracepoints of the UNIX transport. With <sys/sdt.h> (systemtap-sdt)
+ * available each GST_UNIX_TRACE* site compiles to a single nop plus a note
+ * in the ELF file, so the probes cost next to nothing until perf, bpftrace
+ * or systemtap attach to them, e.g.
+ *
+ *   bpftrace -e 'usdt:libgsttcp.so:gstunix:client_push { @[arg0] = hist(arg2); }'
+ *
+ * All probes live in the "gstunix" provider and take the element as first
+ * argument. Define GST_UNIX_DISABLE_SDT to compile them out. */
+
+#if !defined (GST_UNIX_DISABLE_SDT) && defined (__linux__) && \
+    defined (__has_include)
+#if __has_include (<sys/sdt.h>)
+#include <sys/sdt.h>
+#define GST_UNIX_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef GST_UNIX_HAVE_SDT
+#define GST_UNIX_TRACE1(name, a) \
+  DTRACE_PROBE1 (gstunix, name, a)
+#define GST_UNIX_TRACE2(name, a, b) \
+  DTRACE_PROBE2 (gstunix, name, a, b)
+#define GST_UNIX_TRACE3(name, a, b, c) \
+  DTRACE_PROBE3 (gstunix, name, a, b, c)
+#else
+#define GST_UNIX_TRACE1(name, a) G_STMT_START { } G_STMT_END
+#define GST_UNIX_TRACE2(name, a, b) G_STMT_START { } G_STMT_END
+#define GST_UNIX_TRACE3(name, a, b, c) G_STMT_START { } G_STMT_END
+#endif
+
+#endif /* __GST_UNIX_TRACE_H__ */